@@ -0,0 +1,92 @@
+#pragma once
+
+#include "common.hpp"
+
+//* Most producers ever admitted at once (disregard hyperthreading).
+#define ADMISSION_MAX       (TOTAL_CORES/2)
+//* Inserts per thread between two adjustments of the limit.
+#define ADMISSION_WINDOW    256
+//* An insert is contended if it lost the reservation CAS this often or waited this long for its predecessors.
+#define CAS_FAILURE_LIMIT   4
+#define COMMIT_SPIN_LIMIT   1024
+//* Halve the limit if more than 1/ADMISSION_BACKOFF of a window was contended, grow it below 1/ADMISSION_PROBE.
+#define ADMISSION_BACKOFF   4
+#define ADMISSION_PROBE     16
+
+
+//* Per-thread window, so measuring contention does not add a shared counter to every insert.
+thread_local unsigned int tWindowInserts = 0;
+thread_local unsigned int tWindowContended = 0;
+
+//* The limit starts out open (0 after allocation, or ADMISSION_MAX); only contention closes it.
+bool
+AdmissionOpen(
+       int Limit
+) {
+       return Limit == 0 || Limit >= ADMISSION_MAX;
+}
+
+//* Waits until fewer than AdmissionLimit producers are inside the gate, and returns whether it entered the gate.
+//* While the limit is open no producer is counted: the uncontended path costs one relaxed load of a line that
+//* is only written when the limit changes, not two read-modify-writes on Admitted.
+bool
+AdmitProducer(
+       RingBuffer* Ring
+) {
+       for (;;) {
+              int limit = Ring->AdmissionLimit[0].load(std::memory_order_relaxed);
+              if (AdmissionOpen(limit)) {
+                     return false;
+              }
+
+              int admitted = Ring->Admitted[0].load(std::memory_order_relaxed);
+              if (admitted >= limit) {
+                     //* Hand the core to an admitted producer; with busy neighbours it may be the one we wait for.
+                     std::this_thread::yield();
+                     continue;
+              }
+              if (Ring->Admitted[0].compare_exchange_weak(admitted, admitted + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+                     return true;
+              }
+       }
+}
+
+//* Leaves the gate if Admitted entered it and, once per window, adapts the limit: multiplicative decrease under
+//* contention, additive increase otherwise. Producers that passed an open limit are not counted when it closes,
+//* so the gate may briefly admit more than the new limit.
+void
+ReleaseProducer(
+       RingBuffer* Ring,
+       bool Admitted,
+       bool Inserted,
+       bool Contended
+) {
+       if (Admitted) {
+              Ring->Admitted[0].fetch_sub(1, std::memory_order_release);
+       }
+       if (!Inserted) {
+              return;
+       }
+
+       tWindowContended += Contended;
+       if (++tWindowInserts < ADMISSION_WINDOW) {
+              return;
+       }
+
+       int limit = Ring->AdmissionLimit[0].load(std::memory_order_relaxed);
+       int current = (limit == 0)? ADMISSION_MAX : limit;
+       int adjusted = current;
+       if (tWindowContended * ADMISSION_BACKOFF > tWindowInserts) {
+              adjusted = std::max(1, current / 2);
+       }
+       else if (tWindowContended * ADMISSION_PROBE < tWindowInserts) {
+              adjusted = std::min(ADMISSION_MAX, current + 1);
+       }
+       //* Losing this race to another thread's adjustment is fine, the next window retries.
+       if (adjusted != current) {
+              Ring->AdmissionLimit[0].compare_exchange_strong(limit, adjusted, std::memory_order_relaxed);
+       }
+
+       tWindowInserts = 0;
+       tWindowContended = 0;
+}
@@ -0,0 +1,199 @@
+#include "common.hpp"
+
+#define MAX_SUBSCRIBERS 8
+#define NUM_SUBSCRIBERS 3
+
+
+//* Multicast ring: every subscriber owns a read cursor and producers gate on the slowest one.
+struct BroadcastRing {
+       Atomic<int> ForwardTail[INT_ALIGNED];
+       Atomic<int> Tail[INT_ALIGNED];
+       //* Offset where the last lap ended (a frame that does not fit before the end restarts at 0).
+       Atomic<int> WrapAt[INT_ALIGNED];
+       Atomic<int> Cursor[MAX_SUBSCRIBERS][INT_ALIGNED];
+       int NumSubscribers[INT_ALIGNED];
+       char Buffer[RING_SIZE];
+};
+
+BroadcastRing*
+AllocateBroadcastBuffer(
+       BufferT BufferAddress
+) {
+       BroadcastRing* ring = (BroadcastRing*)BufferAddress;
+
+       size_t ringAddress = (size_t)ring;
+       while (ringAddress % CACHE_LINE != 0) {
+              ringAddress++;
+       }
+       ring = (BroadcastRing*)ringAddress;
+
+       memset((void*)ring, 0, sizeof(BroadcastRing));
+       ring->WrapAt[0] = RING_SIZE;
+
+       return ring;
+}
+
+void
+DeallocateBroadcastBuffer(
+       BroadcastRing* Ring
+) {
+       memset((void*)Ring, 0, sizeof(BroadcastRing));
+}
+
+//* Must be called before the producers start; returns the subscriber id or -1 when full.
+int
+BroadcastSubscribe(
+       BroadcastRing* Ring
+) {
+       int subscriber = Ring->NumSubscribers[0];
+       if (subscriber >= MAX_SUBSCRIBERS) {
+              return -1;
+       }
+
+       Ring->Cursor[subscriber][0].store(Ring->Tail[0].load(std::memory_order_acquire), std::memory_order_release);
+       Ring->NumSubscribers[0] = subscriber + 1;
+
+       return subscriber;
+}
+
+//* Bytes between the cursor and the producer side, i.e., how far the slowest subscriber holds producers back.
+RingSizeT
+BroadcastGatingDistance(
+       BroadcastRing* Ring,
+       int ForwardTail
+) {
+       RingSizeT slowest = 0;
+
+       for (int i = 0; i < Ring->NumSubscribers[0]; i++) {
+              int cursor = Ring->Cursor[i][0].load(std::memory_order_acquire);
+              RingSizeT distance = (ForwardTail < cursor)? ForwardTail + RING_SIZE - cursor : ForwardTail - cursor;
+              if (distance > slowest) {
+                     slowest = distance;
+              }
+       }
+
+       return slowest;
+}
+
+//* Committed bytes the subscriber has not released yet.
+RingSizeT
+BroadcastLag(
+       BroadcastRing* Ring,
+       int Subscriber
+) {
+       int tail = Ring->Tail[0].load(std::memory_order_acquire);
+       int cursor = Ring->Cursor[Subscriber][0].load(std::memory_order_relaxed);
+
+       if (tail < cursor) {
+              return tail + Ring->WrapAt[0].load(std::memory_order_relaxed) - cursor;
+       }
+       return tail - cursor;
+}
+
+bool
+BroadcastInsertToMessageBuffer(
+       BroadcastRing* Ring,
+       const BufferT CopyFrom,
+       MessageSizeT MessageSize
+) {
+       MessageSizeT messageBytes = sizeof(MessageSizeT) + MessageSize;
+       while (messageBytes % CACHE_LINE != 0) {
+              messageBytes++;
+       }
+
+       if (messageBytes > FORWARD_DEGREE) {
+              return false;
+       }
+
+       int forwardTail;
+       int nextTail;
+       RingSizeT distance = 0;
+       RingSizeT reservedBytes = 0;
+
+       do {
+              forwardTail = Ring->ForwardTail[0].load(mem_barrier);
+              distance = BroadcastGatingDistance(Ring, forwardTail);
+
+              if (distance >= FORWARD_DEGREE) {
+                     return false;
+              }
+
+              //* Frames are never split: the leftover at the end of the buffer is skipped instead.
+              reservedBytes = messageBytes;
+              if (forwardTail + messageBytes > RING_SIZE) {
+                     reservedBytes += RING_SIZE - forwardTail;
+              }
+
+              if (reservedBytes >= RING_SIZE - distance) {
+                     return false;
+              }
+
+              nextTail = (forwardTail + reservedBytes) % RING_SIZE;
+       } while (Ring->ForwardTail[0].compare_exchange_weak(
+              forwardTail, nextTail, mem_barrier, mem_barrier) == false);
+
+       int frameStart = (reservedBytes == messageBytes)? forwardTail : 0;
+       char* messageAddress = &Ring->Buffer[frameStart];
+
+       *((MessageSizeT*)messageAddress) = messageBytes;
+       CopyToRing(messageAddress + sizeof(MessageSizeT), CopyFrom, MessageSize, distance);
+
+       //* Published by the release on Tail below; subscribers are at least one frame past the previous lap's value.
+       if (nextTail < forwardTail || nextTail == 0) {
+              Ring->WrapAt[0].store((frameStart == 0)? forwardTail : RING_SIZE, std::memory_order_relaxed);
+       }
+
+       while (Ring->Tail[0].load(std::memory_order_acquire) != forwardTail) {
+              std::this_thread::yield();
+       }
+
+       Ring->Tail[0].store(nextTail, std::memory_order_release);
+
+       return true;
+}
+
+//* Hands out the committed frames after the subscriber's cursor in place (no copy).
+//* The region ends at the wrap point, so a wrapped ring takes two calls to drain.
+bool
+BroadcastFetch(
+       BroadcastRing* Ring,
+       int Subscriber,
+       BufferT* Region,
+       MessageSizeT* RegionSize
+) {
+       int tail = Ring->Tail[0].load(std::memory_order_acquire);
+       int cursor = Ring->Cursor[Subscriber][0].load(std::memory_order_relaxed);
+
+       if (tail == cursor) {
+              return false;
+       }
+
+       int end = tail;
+       if (tail < cursor) {
+              end = Ring->WrapAt[0].load(std::memory_order_relaxed);
+              if (cursor >= end) {
+                     cursor = 0;
+                     Ring->Cursor[Subscriber][0].store(0, std::memory_order_release);
+                     end = tail;
+                     if (end == 0) {
+                            return false;
+                     }
+              }
+       }
+
+       *Region = &Ring->Buffer[cursor];
+       *RegionSize = end - cursor;
+
+       return true;
+}
+
+//* Returns the bytes of a region obtained from BroadcastFetch to the producers.
+void
+BroadcastRelease(
+       BroadcastRing* Ring,
+       int Subscriber,
+       MessageSizeT Bytes
+) {
+       int cursor = Ring->Cursor[Subscriber][0].load(std::memory_order_relaxed);
+       Ring->Cursor[Subscriber][0].store((cursor + Bytes) % RING_SIZE, std::memory_order_release);
+}
@@ -8,6 +8,7 @@
 #include <cstring>
 #include <future>
 #include <numeric>
+#include <algorithm>
 #include <string.h>
 
 #define TOTAL_CORES 32
@@ -17,7 +18,11 @@
 #define NUM_MESSAGES 10000000
 #define TOTAL_MESSAGES NUM_PRODUCERS * NUM_MESSAGES
 #define WARMUP_MESSAGES TOTAL_MESSAGES * 0.05
+//* Runs per producer count; the overhead targets raise it (-DREPEATS=...) to bound small differences.
+#ifndef REPEATS
 #define REPEATS 3
+#endif
+#define CONSUME_BATCH FORWARD_DEGREE / CACHE_LINE
 
 
 #ifdef MEM_RELAXED
@@ -26,6 +31,35 @@
        #define mem_barrier std::memory_order_seq_cst // default
 #endif
 
+//* Ordering of each synchronization site of the Tail-committing inserts (tail, optimized, ticket, auto) and the
+//* consumer. The defaults are the weakest correct choice: the CAS only hands out space, the Head load orders the
+//* copy after the consumer released the bytes, the commit wait chains the previous producer's data into this
+//* producer's release, and the consumer acquires Tail and releases Head. Override a site with, for example,
+//* -DORDER_COMMIT=std::memory_order_seq_cst, or all of them with -DORDER_SEQ_CST (see the ablation target).
+#ifdef ORDER_SEQ_CST
+       #define ORDER_MINIMAL(Order) std::memory_order_seq_cst
+#else
+       #define ORDER_MINIMAL(Order) Order
+#endif
+#ifndef ORDER_RESERVE
+       #define ORDER_RESERVE       ORDER_MINIMAL(std::memory_order_relaxed)
+#endif
+#ifndef ORDER_HEAD_LOAD
+       #define ORDER_HEAD_LOAD     ORDER_MINIMAL(std::memory_order_acquire)
+#endif
+#ifndef ORDER_COMMIT_WAIT
+       #define ORDER_COMMIT_WAIT   ORDER_MINIMAL(std::memory_order_acquire)
+#endif
+#ifndef ORDER_COMMIT
+       #define ORDER_COMMIT        ORDER_MINIMAL(std::memory_order_release)
+#endif
+#ifndef ORDER_TAIL_LOAD
+       #define ORDER_TAIL_LOAD     ORDER_MINIMAL(std::memory_order_acquire)
+#endif
+#ifndef ORDER_HEAD_PUBLISH
+       #define ORDER_HEAD_PUBLISH  ORDER_MINIMAL(std::memory_order_release)
+#endif
+
 std::mutex mtx;
 std::condition_variable cond;
 
@@ -67,11 +101,23 @@ void writeCSV(const std::string& filename, const std::vector<std::vector<std::st
 #pragma once
 
 #include <atomic>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <climits>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 #define RING_SIZE           16777216
 #define FORWARD_DEGREE      1048576
 #define CACHE_LINE          64
 #define INT_ALIGNED         16
+#define PREFETCH_FRAMES     4
+
+#include "copy.hpp"
+#include "trace.hpp"
+#include "telemetry.hpp"
  
 template <class C>
 using Atomic = std::atomic<C>;
@@ -82,11 +128,66 @@ typedef unsigned int RingSizeT;
 struct RingBuffer {
        Atomic<int> ForwardTail[INT_ALIGNED];
        Atomic<int> SafeTail[INT_ALIGNED];
-       int Tail;
-       int Head[INT_ALIGNED];
+       //* Commit point of the Tail-committing inserts; -1 for the modes that commit through SafeTail.
+       Atomic<int> Tail;
+       Atomic<int> Head[INT_ALIGNED];
+       //* Producer-owned copy of Head, refreshed only when the ring looks full (SPSC mode).
+       int CachedHead[INT_ALIGNED];
+       int NumProducers[INT_ALIGNED];
+       //* Threads sleeping on Head (producers) or on the tail word (consumer), see deadline.hpp.
+       Atomic<int> ParkedProducers[INT_ALIGNED];
+       Atomic<int> ParkedConsumer[INT_ALIGNED];
+       //* Admission gate of the optimized insert, see admission.hpp.
+       Atomic<int> AdmissionLimit[INT_ALIGNED];
+       Atomic<int> Admitted[INT_ALIGNED];
+       //* Ticket-ordered reservation, see ticket.hpp.
+       Atomic<unsigned int> NextTicket[INT_ALIGNED];
+       Atomic<unsigned int> NowServing[INT_ALIGNED];
        char Buffer[RING_SIZE];
 };
 
+using InsertFunctionT = bool (*)(RingBuffer*, const BufferT, MessageSizeT);
+
+//* Sleeps while *Word == Observed, for at most TimeoutNs.
+void
+ParkOn(
+       void* Word,
+       int Observed,
+       long TimeoutNs
+) {
+       struct timespec timeout = {TimeoutNs / 1000000000, TimeoutNs % 1000000000};
+       syscall(SYS_futex, Word, FUTEX_WAIT_PRIVATE, Observed, &timeout, nullptr, 0);
+}
+
+void
+WakeParked(
+       void* Word
+) {
+       syscall(SYS_futex, Word, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+}
+
+//* Hands consumed bytes back to the producers. Parked producers are woken; the check is a relaxed load,
+//* so a producer that parks concurrently may sleep until its park slice runs out.
+void
+ReleaseToProducers(
+       RingBuffer* Ring,
+       int Head
+) {
+       Ring->Head[0].store(Head, ORDER_HEAD_PUBLISH);
+       if (Ring->ParkedProducers[0].load(std::memory_order_relaxed)) {
+              WakeParked(&Ring->Head[0]);
+       }
+}
+
+//* Where committed data ends, as the consumer sees it: Tail in the modes that commit through it, SafeTail otherwise.
+int
+CommittedTail(
+       RingBuffer* Ring
+) {
+       int tail = Ring->Tail.load(ORDER_TAIL_LOAD);
+       return (tail < 0)? Ring->SafeTail[0].load(mem_barrier) : tail;
+}
+
 RingBuffer*
 AllocateMessageBuffer(
        BufferT BufferAddress
@@ -99,7 +200,7 @@ AllocateMessageBuffer(
        }
        ringBuffer = (RingBuffer*)ringBufferAddress;
  
-       memset(ringBuffer, 0, sizeof(RingBuffer));
+       memset((void*)ringBuffer, 0, sizeof(RingBuffer));
  
        return ringBuffer;
 }
@@ -108,7 +209,7 @@ void
 DeallocateMessageBuffer(
        RingBuffer* Ring
 ) {
-       memset(Ring, 0, sizeof(RingBuffer));
+       memset((void*)Ring, 0, sizeof(RingBuffer));
 }
 
 bool
@@ -117,9 +218,9 @@ FetchFromMessageBuffer(
        BufferT CopyTo,
        MessageSizeT* MessageSize
 ) {
-       int safeTail = (Ring->Tail < 0)? Ring->SafeTail[0].load(mem_barrier) : Ring->Tail;
+       int safeTail = CommittedTail(Ring);
        int forwardTail = Ring->ForwardTail[0].load(mem_barrier);
-       int head = Ring->Head[0];
+       int head = Ring->Head[0].load(std::memory_order_relaxed);
  
        if (forwardTail == head) {
               return false;
@@ -145,15 +246,16 @@ FetchFromMessageBuffer(
               sourceBuffer2 = &Ring->Buffer[0];
        }
  
-       memcpy(CopyTo, sourceBuffer1, availBytes);
-       memset(sourceBuffer1, 0, availBytes);
+       CopyKernel(CopyTo, sourceBuffer1, availBytes, true);
+       ZeroRing(sourceBuffer1, availBytes);
  
        if (sourceBuffer2) {
-              memcpy((char*)CopyTo + availBytes, sourceBuffer2, safeTail);
-              memset(sourceBuffer2, 0, safeTail);
+              CopyKernel((char*)CopyTo + availBytes, sourceBuffer2, safeTail, true);
+              ZeroRing(sourceBuffer2, safeTail);
        }
  
-       Ring->Head[0] = safeTail;
+       ReleaseToProducers(Ring, safeTail);
+       TELEMETRY_COUNT(DrainedBytes, *MessageSize);
  
        return true;
 }
@@ -181,3 +283,113 @@ ParseNextMessage(
               *StartOfNext = nullptr;
        }
 }
+
+//* Number of consecutive frames starting at Frame whose length header equals FrameBytes.
+//* Headers sit at a fixed stride, so they are gathered 8 at a time instead of chased one by one.
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2")))
+size_t
+CountUniformFramesAvx2(
+       const char* Frame,
+       MessageSizeT FrameBytes,
+       size_t MaxFrames
+) {
+       const __m256i expected = _mm256_set1_epi32(FrameBytes);
+       const __m256i offsets = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), expected);
+       size_t count = 0;
+
+       while (count + 8 <= MaxFrames) {
+              __m256i headers = _mm256_i32gather_epi32((const int*)(Frame + count * FrameBytes), offsets, 1);
+              unsigned int mask = _mm256_movemask_epi8(_mm256_cmpeq_epi32(headers, expected));
+              if (mask != 0xFFFFFFFF) {
+                     return count + __builtin_ctz(~mask) / sizeof(MessageSizeT);
+              }
+              count += 8;
+       }
+
+       while (count < MaxFrames && *(const MessageSizeT*)(Frame + count * FrameBytes) == FrameBytes) {
+              count++;
+       }
+
+       return count;
+}
+#endif
+
+size_t
+CountUniformFrames(
+       const char* Frame,
+       MessageSizeT FrameBytes,
+       size_t MaxFrames
+) {
+#if defined(__x86_64__) || defined(__i386__)
+       static const bool hasAvx2 = __builtin_cpu_supports("avx2");
+       if (hasAvx2) {
+              return CountUniformFramesAvx2(Frame, FrameBytes, MaxFrames);
+       }
+#endif
+
+       size_t count = 0;
+       while (count < MaxFrames && *(const MessageSizeT*)(Frame + count * FrameBytes) == FrameBytes) {
+              count++;
+       }
+
+       return count;
+}
+
+//* Walks the committed region in place and calls Visitor(Message, MessageSize) for up to MaxBatch frames.
+//* Only a frame split by the wrap is copied (into a scratch buffer). Returns the number of frames consumed.
+template <class VisitorT>
+size_t
+ConsumeMessages(
+       RingBuffer* Ring,
+       VisitorT Visitor,
+       size_t MaxBatch
+) {
+       int safeTail = CommittedTail(Ring);
+       int forwardTail = Ring->ForwardTail[0].load(mem_barrier);
+       int head = Ring->Head[0].load(std::memory_order_relaxed);
+
+       if (forwardTail == head) {
+              return 0;
+       }
+
+       if (forwardTail != safeTail) {
+              return 0;
+       }
+
+       static thread_local std::vector<char> scratch;
+       size_t consumed = 0;
+       TRACE_EVENT(TRACE_PICKUP, head, 0);
+
+       while (head != safeTail && consumed < MaxBatch) {
+              char* frame = &Ring->Buffer[head];
+              MessageSizeT frameBytes = *(MessageSizeT*)frame;
+              RingSizeT contiguousBytes = (safeTail > head)? safeTail - head : RING_SIZE - head;
+
+              if (frameBytes <= contiguousBytes) {
+                     //* Run of equally sized frames: addresses are known up front, no dependent header loads.
+                     size_t run = CountUniformFrames(frame, frameBytes, std::min<size_t>(contiguousBytes / frameBytes, MaxBatch - consumed));
+                     for (size_t i = 0; i < run; i++) {
+                            __builtin_prefetch(frame + (i + PREFETCH_FRAMES) * frameBytes);
+                            Visitor((BufferT)(frame + i * frameBytes + sizeof(MessageSizeT)), frameBytes - sizeof(MessageSizeT));
+                     }
+                     head = (head + run * frameBytes) % RING_SIZE;
+                     consumed += run;
+              }
+              else {
+                     RingSizeT firstBytes = RING_SIZE - head;
+                     scratch.resize(frameBytes);
+                     memcpy(scratch.data(), frame, firstBytes);
+                     memcpy(scratch.data() + firstBytes, &Ring->Buffer[0], frameBytes - firstBytes);
+                     Visitor((BufferT)(scratch.data() + sizeof(MessageSizeT)), frameBytes - sizeof(MessageSizeT));
+                     head = frameBytes - firstBytes;
+                     consumed++;
+              }
+       }
+
+       TELEMETRY_COUNT(DrainedBytes, (head - Ring->Head[0].load(std::memory_order_relaxed) + RING_SIZE) % RING_SIZE);
+       ReleaseToProducers(Ring, head);
+       TRACE_EVENT(TRACE_RELEASE, head, consumed);
+
+       return consumed;
+}
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <cstring>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+//* Copies at or above this size bypass the cache even if the data is read soon (it would not stay in L2 anyway).
+#define STREAM_THRESHOLD    262144
+//* Below this size the alignment prologue of a streaming copy costs more than it saves.
+#define STREAM_MIN          1024
+
+typedef void (*CopyKernelT)(void*, const void*, size_t);
+typedef void (*ZeroKernelT)(void*, size_t);
+
+struct CopyKernels {
+       const char* Name;
+       CopyKernelT Stream;
+       ZeroKernelT StreamZero;
+};
+
+void
+CopyPlain(
+       void* CopyTo,
+       const void* CopyFrom,
+       size_t Bytes
+) {
+       memcpy(CopyTo, CopyFrom, Bytes);
+}
+
+void
+ZeroPlain(
+       void* ZeroAt,
+       size_t Bytes
+) {
+       memset(ZeroAt, 0, Bytes);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+//* Streaming kernels: cached copy up to the first aligned destination, non-temporal stores for the bulk,
+//* then an sfence so a later commit of Tail cannot overtake the write-combining buffers.
+#define DEFINE_STREAM_KERNELS(Isa, Target, VectorT, Width, LoadU, Stream, SetZero)                    \
+__attribute__((target(Target)))                                                                       \
+void                                                                                                  \
+CopyStream##Isa(                                                                                      \
+       void* CopyTo,                                                                                  \
+       const void* CopyFrom,                                                                          \
+       size_t Bytes                                                                                   \
+) {                                                                                                   \
+       char* to = (char*)CopyTo;                                                                      \
+       const char* from = (const char*)CopyFrom;                                                      \
+       size_t prologue = (Width - ((uintptr_t)to % Width)) % Width;                                   \
+       if (prologue > Bytes) {                                                                        \
+              prologue = Bytes;                                                                       \
+       }                                                                                              \
+       memcpy(to, from, prologue);                                                                    \
+       to += prologue;                                                                                \
+       from += prologue;                                                                              \
+       Bytes -= prologue;                                                                             \
+                                                                                                      \
+       for (; Bytes >= 4 * Width; Bytes -= 4 * Width, to += 4 * Width, from += 4 * Width) {           \
+              VectorT v0 = LoadU((const VectorT*)(from));                                             \
+              VectorT v1 = LoadU((const VectorT*)(from + Width));                                     \
+              VectorT v2 = LoadU((const VectorT*)(from + 2 * Width));                                 \
+              VectorT v3 = LoadU((const VectorT*)(from + 3 * Width));                                 \
+              Stream((VectorT*)(to), v0);                                                             \
+              Stream((VectorT*)(to + Width), v1);                                                     \
+              Stream((VectorT*)(to + 2 * Width), v2);                                                 \
+              Stream((VectorT*)(to + 3 * Width), v3);                                                 \
+       }                                                                                              \
+       for (; Bytes >= Width; Bytes -= Width, to += Width, from += Width) {                           \
+              Stream((VectorT*)to, LoadU((const VectorT*)from));                                      \
+       }                                                                                              \
+       memcpy(to, from, Bytes);                                                                       \
+       _mm_sfence();                                                                                  \
+}                                                                                                     \
+                                                                                                      \
+__attribute__((target(Target)))                                                                       \
+void                                                                                                  \
+ZeroStream##Isa(                                                                                      \
+       void* ZeroAt,                                                                                  \
+       size_t Bytes                                                                                   \
+) {                                                                                                   \
+       char* to = (char*)ZeroAt;                                                                      \
+       size_t prologue = (Width - ((uintptr_t)to % Width)) % Width;                                   \
+       if (prologue > Bytes) {                                                                        \
+              prologue = Bytes;                                                                       \
+       }                                                                                              \
+       memset(to, 0, prologue);                                                                       \
+       to += prologue;                                                                                \
+       Bytes -= prologue;                                                                             \
+                                                                                                      \
+       const VectorT zero = SetZero();                                                                \
+       for (; Bytes >= Width; Bytes -= Width, to += Width) {                                          \
+              Stream((VectorT*)to, zero);                                                             \
+       }                                                                                              \
+       memset(to, 0, Bytes);                                                                          \
+       _mm_sfence();                                                                                  \
+}
+
+DEFINE_STREAM_KERNELS(Sse2, "sse2", __m128i, 16, _mm_loadu_si128, _mm_stream_si128, _mm_setzero_si128)
+DEFINE_STREAM_KERNELS(Avx2, "avx2", __m256i, 32, _mm256_loadu_si256, _mm256_stream_si256, _mm256_setzero_si256)
+DEFINE_STREAM_KERNELS(Avx512, "avx512f", __m512i, 64, _mm512_loadu_si512, _mm512_stream_si512, _mm512_setzero_si512)
+#endif
+
+//* All kernels usable on this CPU, plain first and widest last.
+std::vector<CopyKernels>
+AvailableCopyKernels() {
+       std::vector<CopyKernels> kernels = {{"plain", &CopyPlain, &ZeroPlain}};
+#if defined(__x86_64__) || defined(__i386__)
+       __builtin_cpu_init();
+       if (__builtin_cpu_supports("sse2")) {
+              kernels.push_back({"sse2", &CopyStreamSse2, &ZeroStreamSse2});
+       }
+       if (__builtin_cpu_supports("avx2")) {
+              kernels.push_back({"avx2", &CopyStreamAvx2, &ZeroStreamAvx2});
+       }
+       if (__builtin_cpu_supports("avx512f")) {
+              kernels.push_back({"avx512", &CopyStreamAvx512, &ZeroStreamAvx512});
+       }
+#endif
+       return kernels;
+}
+
+//* Resolved once on first use.
+const CopyKernels&
+SelectedCopyKernels() {
+       static const CopyKernels selected = AvailableCopyKernels().back();
+       return selected;
+}
+
+//* Cached copy when the destination is read soon and small enough to stay in cache, streaming otherwise.
+void
+CopyKernel(
+       void* CopyTo,
+       const void* CopyFrom,
+       size_t Bytes,
+       bool ReadSoon
+) {
+       if (Bytes < STREAM_MIN || (ReadSoon && Bytes < STREAM_THRESHOLD)) {
+              memcpy(CopyTo, CopyFrom, Bytes);
+              return;
+       }
+       SelectedCopyKernels().Stream(CopyTo, CopyFrom, Bytes);
+}
+
+//* Bytes written after a frame that evict it before it is read: the last-level cache, resolved once.
+//* Falls back to STREAM_THRESHOLD where the C library does not report cache sizes.
+size_t
+StreamBacklog() {
+       static const size_t backlog = [] {
+              long bytes = 0;
+#if defined(_SC_LEVEL3_CACHE_SIZE) && defined(_SC_LEVEL2_CACHE_SIZE)
+              bytes = sysconf(_SC_LEVEL3_CACHE_SIZE);
+              if (bytes <= 0) {
+                     bytes = sysconf(_SC_LEVEL2_CACHE_SIZE);
+              }
+#endif
+              return (bytes > 0)? (size_t)bytes : (size_t)STREAM_THRESHOLD;
+       }();
+       return backlog;
+}
+
+//* Producer frame writes. Backlog is what the consumer still has to read before it reaches the frame;
+//* the frame is streamed only if it would leave the cache before then.
+void
+CopyToRing(
+       void* CopyTo,
+       const void* CopyFrom,
+       size_t Bytes,
+       size_t Backlog
+) {
+       CopyKernel(CopyTo, CopyFrom, Bytes, Backlog + Bytes < StreamBacklog());
+}
+
+//* Zeroed ring bytes are not touched again until the producers wrap around.
+void
+ZeroRing(
+       void* ZeroAt,
+       size_t Bytes
+) {
+       if (Bytes < STREAM_MIN) {
+              memset(ZeroAt, 0, Bytes);
+              return;
+       }
+       SelectedCopyKernels().StreamZero(ZeroAt, Bytes);
+}
@@ -0,0 +1,288 @@
+#include "common.hpp"
+#include "tail.hpp"
+
+#include <coroutine>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+//* Coroutine front end for the ring (C++20). A full or empty ring suspends the awaiting coroutine instead of
+//* its thread; whoever makes progress later performs the pending operation on the waiter's behalf and hands
+//* the coroutine back to the executor it was suspended on.
+
+
+//* Single-threaded executor: coroutines spawned on it, and every coroutine it resumes, run on the thread in RunExecutor.
+struct Executor {
+       std::mutex Lock;
+       std::condition_variable Wakeup;
+       std::deque<std::coroutine_handle<>> Ready;
+       std::atomic<size_t> Live{0};
+       size_t Resumes = 0;
+};
+
+thread_local Executor* CurrentExecutor = nullptr;
+
+void
+Schedule(
+       Executor* Exec,
+       std::coroutine_handle<> Handle
+) {
+       {
+              std::lock_guard<std::mutex> guard(Exec->Lock);
+              Exec->Ready.push_back(Handle);
+       }
+       if (Exec != CurrentExecutor) {
+              Exec->Wakeup.notify_one();
+       }
+}
+
+//* Fire-and-forget coroutine; its frame is freed when it returns and the executor counts it down.
+struct Task {
+       struct promise_type {
+              Executor* Exec = nullptr;
+
+              Task get_return_object() { return Task{std::coroutine_handle<promise_type>::from_promise(*this)}; }
+              std::suspend_always initial_suspend() noexcept { return {}; }
+              std::suspend_never final_suspend() noexcept {
+                     Exec->Live.fetch_sub(1);
+                     Exec->Wakeup.notify_one();
+                     return {};
+              }
+              void return_void() {}
+              void unhandled_exception() { std::terminate(); }
+       };
+
+       std::coroutine_handle<promise_type> Handle;
+};
+
+void
+Spawn(
+       Executor* Exec,
+       Task Coroutine
+) {
+       Coroutine.Handle.promise().Exec = Exec;
+       Exec->Live.fetch_add(1);
+       Schedule(Exec, Coroutine.Handle);
+}
+
+//* Resumes ready coroutines until every coroutine spawned on Exec has returned.
+void
+RunExecutor(
+       Executor* Exec
+) {
+       CurrentExecutor = Exec;
+       std::unique_lock<std::mutex> lock(Exec->Lock);
+
+       while (Exec->Live.load() > 0 || !Exec->Ready.empty()) {
+              if (Exec->Ready.empty()) {
+                     Exec->Wakeup.wait(lock, [&] { return !Exec->Ready.empty() || Exec->Live.load() == 0; });
+                     continue;
+              }
+              std::coroutine_handle<> handle = Exec->Ready.front();
+              Exec->Ready.pop_front();
+
+              lock.unlock();
+              handle.resume();
+              Exec->Resumes++;
+              lock.lock();
+       }
+       CurrentExecutor = nullptr;
+}
+
+//* A suspended operation with its arguments, so whoever unblocks it can complete it.
+struct RingWaiter {
+       std::coroutine_handle<> Handle;
+       Executor* Exec;
+       BufferT Message;
+       MessageSizeT* MessageSize;
+};
+
+//* Wait lists are FIFO, so a producer that suspended first is served first once space frees up.
+//* Parked counters let the fast path skip the lock when nobody waits.
+struct AsyncRing {
+       RingBuffer* Ring;
+       InsertFunctionT InsertFunction;
+
+       std::mutex InsertLock;
+       std::deque<RingWaiter> InsertWaiters;
+       Atomic<int> ParkedInserts;
+
+       std::mutex FetchLock;
+       std::deque<RingWaiter> FetchWaiters;
+       Atomic<int> ParkedFetches;
+
+       Atomic<unsigned long long> Suspensions;
+
+       struct InsertAwaitable;
+       struct FetchAwaitable;
+
+       InsertAwaitable Insert(const BufferT CopyFrom, MessageSizeT MessageSize);
+       FetchAwaitable Fetch(BufferT CopyTo);
+};
+
+void
+InitAsyncRing(
+       AsyncRing* Async,
+       RingBuffer* Ring
+) {
+       Async->Ring = Ring;
+       Async->InsertFunction = &TailInsertToMessageBuffer;
+       Async->ParkedInserts.store(0);
+       Async->ParkedFetches.store(0);
+       Async->Suspensions.store(0);
+}
+
+//* Completes waiting inserts in order until one does not fit. Returns whether any completed.
+bool
+WakeInserters(
+       AsyncRing* Async
+) {
+       if (Async->ParkedInserts.load(std::memory_order_seq_cst) == 0) {
+              return false;
+       }
+
+       bool progressed = false;
+       std::lock_guard<std::mutex> guard(Async->InsertLock);
+       while (!Async->InsertWaiters.empty()) {
+              RingWaiter& waiter = Async->InsertWaiters.front();
+              if (!Async->InsertFunction(Async->Ring, waiter.Message, *waiter.MessageSize)) {
+                     break;
+              }
+              Schedule(waiter.Exec, waiter.Handle);
+              Async->InsertWaiters.pop_front();
+              Async->ParkedInserts.fetch_sub(1);
+              progressed = true;
+       }
+       return progressed;
+}
+
+//* Completes the waiting fetch if data is committed. Returns whether it completed.
+bool
+WakeFetcher(
+       AsyncRing* Async
+) {
+       if (Async->ParkedFetches.load(std::memory_order_seq_cst) == 0) {
+              return false;
+       }
+
+       std::lock_guard<std::mutex> guard(Async->FetchLock);
+       if (Async->FetchWaiters.empty()) {
+              return false;
+       }
+       RingWaiter& waiter = Async->FetchWaiters.front();
+       if (!FetchFromMessageBuffer(Async->Ring, waiter.Message, waiter.MessageSize)) {
+              return false;
+       }
+       Schedule(waiter.Exec, waiter.Handle);
+       Async->FetchWaiters.pop_front();
+       Async->ParkedFetches.fetch_sub(1);
+       return true;
+}
+
+//* Called after every completed operation: freed space may complete inserts, whose data may complete the fetch, and so on.
+void
+WakeWaiters(
+       AsyncRing* Async
+) {
+       std::atomic_thread_fence(std::memory_order_seq_cst);
+       bool progressed = true;
+       while (progressed) {
+              progressed = WakeInserters(Async);
+              progressed = WakeFetcher(Async) || progressed;
+       }
+}
+
+//* Registers the waiter, then retries under the wait-list lock. Announcing before the retry means a concurrent
+//* completion either sees the waiter or happened before the retry, so no wakeup is lost.
+template <class OperationT>
+bool
+SuspendUnlessDone(
+       AsyncRing* Async,
+       std::mutex* Lock,
+       std::deque<RingWaiter>* Waiters,
+       Atomic<int>* Parked,
+       const RingWaiter& Waiter,
+       OperationT Operation
+) {
+       std::lock_guard<std::mutex> guard(*Lock);
+       Parked->fetch_add(1, std::memory_order_seq_cst);
+       if (Operation()) {
+              Parked->fetch_sub(1);
+              return false;
+       }
+       Waiters->push_back(Waiter);
+       Async->Suspensions.fetch_add(1, std::memory_order_relaxed);
+       return true;
+}
+
+struct AsyncRing::InsertAwaitable {
+       AsyncRing* Async;
+       BufferT CopyFrom;
+       MessageSizeT MessageSize;
+       bool Suspended;
+
+       bool await_ready() {
+              //* Queued producers go first, so a fresh one cannot overtake them.
+              Suspended = false;
+              return Async->ParkedInserts.load(std::memory_order_relaxed) == 0
+                     && Async->InsertFunction(Async->Ring, CopyFrom, MessageSize);
+       }
+
+       bool await_suspend(std::coroutine_handle<> Handle) {
+              Suspended = SuspendUnlessDone(Async, &Async->InsertLock, &Async->InsertWaiters, &Async->ParkedInserts,
+                     RingWaiter{Handle, CurrentExecutor, CopyFrom, &MessageSize},
+                     [&] { return Async->InsertWaiters.empty() && Async->InsertFunction(Async->Ring, CopyFrom, MessageSize); });
+              return Suspended;
+       }
+
+       //* A completed wait was finished by the waker, which also woke whoever that unblocked.
+       void await_resume() {
+              if (!Suspended) {
+                     WakeWaiters(Async);
+              }
+       }
+};
+
+struct AsyncRing::FetchAwaitable {
+       AsyncRing* Async;
+       BufferT CopyTo;
+       MessageSizeT MessageSize;
+       bool Suspended;
+
+       bool await_ready() {
+              Suspended = false;
+              return FetchFromMessageBuffer(Async->Ring, CopyTo, &MessageSize);
+       }
+
+       bool await_suspend(std::coroutine_handle<> Handle) {
+              Suspended = SuspendUnlessDone(Async, &Async->FetchLock, &Async->FetchWaiters, &Async->ParkedFetches,
+                     RingWaiter{Handle, CurrentExecutor, CopyTo, &MessageSize},
+                     [&] { return FetchFromMessageBuffer(Async->Ring, CopyTo, &MessageSize); });
+              return Suspended;
+       }
+
+       //* Returns the bytes fetched (whole frames, as FetchFromMessageBuffer).
+       MessageSizeT await_resume() {
+              if (!Suspended) {
+                     WakeWaiters(Async);
+              }
+              return MessageSize;
+       }
+};
+
+//* co_await Async->Insert(Message, Size) suspends until the message is in the ring.
+AsyncRing::InsertAwaitable
+AsyncRing::Insert(
+       const BufferT CopyFrom,
+       MessageSizeT MessageSize
+) {
+       return InsertAwaitable{this, CopyFrom, MessageSize, false};
+}
+
+//* co_await Async->Fetch(CopyTo) suspends until committed data was copied to CopyTo and returns its size.
+AsyncRing::FetchAwaitable
+AsyncRing::Fetch(
+       BufferT CopyTo
+) {
+       return FetchAwaitable{this, CopyTo, 0, false};
+}
@@ -0,0 +1,152 @@
+#include "common.hpp"
+
+//* Attempts spent spinning, then yielding, before a waiter parks on a futex.
+#define SPIN_ITERATIONS     256
+#define YIELD_ITERATIONS    64
+//* Longest single sleep; bounds the delay of a wakeup that raced with parking.
+#define PARK_SLICE_US       1000
+
+using DeadlineT = std::chrono::steady_clock::time_point;
+using TimeoutT = std::chrono::steady_clock::duration;
+
+
+void
+CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+       _mm_pause();
+#elif defined(__aarch64__)
+       asm volatile("yield");
+#endif
+}
+
+//* The word the consumer waits on: Tail for the modes that commit through it, SafeTail otherwise.
+int*
+TailWord(
+       RingBuffer* Ring
+) {
+       return (Ring->Tail.load(std::memory_order_relaxed) < 0)? (int*)&Ring->SafeTail[0] : (int*)&Ring->Tail;
+}
+
+//* Retries Attempt with a spin, yield, park ladder until it succeeds or Deadline passes.
+//* Short waits never leave the CPU; long ones sleep on Word until someone changes it and wakes Parked.
+template <class AttemptT>
+bool
+WaitUntil(
+       AttemptT Attempt,
+       int* Word,
+       Atomic<int>* Parked,
+       DeadlineT Deadline
+) {
+       for (unsigned int round = 0; ; round++) {
+              if (Attempt()) {
+                     return true;
+              }
+              if (round < SPIN_ITERATIONS) {
+                     CpuRelax();
+                     continue;
+              }
+
+              DeadlineT now = std::chrono::steady_clock::now();
+              if (now >= Deadline) {
+                     return false;
+              }
+              if (round < SPIN_ITERATIONS + YIELD_ITERATIONS) {
+                     std::this_thread::yield();
+                     continue;
+              }
+
+              //* Announce first, then sample the word and retry, so an update after the sample fails the futex compare.
+              Parked->fetch_add(1, std::memory_order_seq_cst);
+              int observed = __atomic_load_n(Word, __ATOMIC_SEQ_CST);
+              if (Attempt()) {
+                     Parked->fetch_sub(1, std::memory_order_relaxed);
+                     return true;
+              }
+              long remaining = std::chrono::duration_cast<std::chrono::nanoseconds>(Deadline - now).count();
+              ParkOn(Word, observed, std::min(remaining, PARK_SLICE_US * 1000L));
+              Parked->fetch_sub(1, std::memory_order_relaxed);
+       }
+}
+
+//* Inserts with Insert, waiting for space until Deadline. Returns false if the deadline passed first.
+bool
+InsertUntil(
+       InsertFunctionT Insert,
+       RingBuffer* Ring,
+       const BufferT CopyFrom,
+       MessageSizeT MessageSize,
+       DeadlineT Deadline
+) {
+       bool inserted = WaitUntil([&] {
+              return Insert(Ring, CopyFrom, MessageSize);
+       }, (int*)&Ring->Head[0], &Ring->ParkedProducers[0], Deadline);
+
+       if (inserted && Ring->ParkedConsumer[0].load(std::memory_order_relaxed)) {
+              WakeParked(TailWord(Ring));
+       }
+       return inserted;
+}
+
+bool
+InsertFor(
+       InsertFunctionT Insert,
+       RingBuffer* Ring,
+       const BufferT CopyFrom,
+       MessageSizeT MessageSize,
+       TimeoutT Timeout
+) {
+       return InsertUntil(Insert, Ring, CopyFrom, MessageSize, std::chrono::steady_clock::now() + Timeout);
+}
+
+//* FetchFromMessageBuffer that waits for committed data until Deadline.
+bool
+FetchUntil(
+       RingBuffer* Ring,
+       BufferT CopyTo,
+       MessageSizeT* MessageSize,
+       DeadlineT Deadline
+) {
+       return WaitUntil([&] {
+              return FetchFromMessageBuffer(Ring, CopyTo, MessageSize);
+       }, TailWord(Ring), &Ring->ParkedConsumer[0], Deadline);
+}
+
+bool
+FetchFor(
+       RingBuffer* Ring,
+       BufferT CopyTo,
+       MessageSizeT* MessageSize,
+       TimeoutT Timeout
+) {
+       return FetchUntil(Ring, CopyTo, MessageSize, std::chrono::steady_clock::now() + Timeout);
+}
+
+//* ConsumeMessages that waits for committed data until Deadline. Returns the frames consumed, 0 on timeout.
+//* Producers that insert without InsertUntil/InsertFor do not wake the consumer; it then notices within PARK_SLICE_US.
+template <class VisitorT>
+size_t
+ConsumeUntil(
+       RingBuffer* Ring,
+       VisitorT Visitor,
+       size_t MaxBatch,
+       DeadlineT Deadline
+) {
+       size_t consumed = 0;
+       WaitUntil([&] {
+              consumed = ConsumeMessages(Ring, Visitor, MaxBatch);
+              return consumed > 0;
+       }, TailWord(Ring), &Ring->ParkedConsumer[0], Deadline);
+
+       return consumed;
+}
+
+template <class VisitorT>
+size_t
+ConsumeFor(
+       RingBuffer* Ring,
+       VisitorT Visitor,
+       size_t MaxBatch,
+       TimeoutT Timeout
+) {
+       return ConsumeUntil(Ring, Visitor, MaxBatch, std::chrono::steady_clock::now() + Timeout);
+}
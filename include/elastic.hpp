@@ -0,0 +1,372 @@
+#include "common.hpp"
+
+//* Capacity bounds of an elastic ring; capacities are powers of two.
+#define ELASTIC_MIN         65536
+#define ELASTIC_MAX         RING_SIZE
+//* Occupancy watermarks in 1/ELASTIC_SCALE of the capacity.
+#define ELASTIC_SCALE       16
+#define ELASTIC_HIGH        12
+#define ELASTIC_LOW         2
+//* Resizing is decided per sampling window; shrinking waits much longer than growing to avoid flapping.
+#define ELASTIC_WINDOW_US   1000
+#define ELASTIC_GROW_WINDOWS 3
+#define ELASTIC_GROW_HORIZON_US 20000
+#define ELASTIC_SHRINK_US   50000
+#define MAX_ELASTIC_PRODUCERS 64
+#define ELASTIC_SEALED      (1u << 31)
+#define ELASTIC_SPIN_LIMIT  1024
+
+
+//* One circular backing buffer. Producers reserve on ForwardTail and commit in order on Tail, as in the
+//* optimized ring. A resize seals the segment (ELASTIC_SEALED in ForwardTail) and links its successor.
+struct ElasticSegment {
+       Atomic<unsigned int> ForwardTail[INT_ALIGNED];
+       Atomic<unsigned int> Tail[INT_ALIGNED];
+       Atomic<unsigned int> Head[INT_ALIGNED];
+       //* Set by producers that found the segment full.
+       Atomic<unsigned int> Saturated[INT_ALIGNED];
+       unsigned int Capacity;
+       ElasticSegment* Next;
+       BufferT Allocation;
+       char* Data;
+};
+
+//* Producers write to Current; the consumer drains Reading, which trails Current during a switchover.
+//* Retired segments are freed once every producer that could still hold a pointer to them has left (epochs).
+struct ElasticRing {
+       Atomic<ElasticSegment*> Current[INT_ALIGNED / 2];
+       Atomic<unsigned long long> Epoch[INT_ALIGNED / 2];
+       //* Epoch a producer entered its insert in, 0 while outside; one cache line per producer.
+       Atomic<unsigned long long> Announced[MAX_ELASTIC_PRODUCERS][INT_ALIGNED / 2];
+       Atomic<int> NumProducers[INT_ALIGNED];
+
+       //* Consumer-owned.
+       ElasticSegment* Reading;
+       std::vector<std::pair<ElasticSegment*, unsigned long long>> Retired;
+       std::chrono::steady_clock::time_point WindowStart;
+       unsigned int WindowPeak;
+       std::chrono::steady_clock::time_point PressureSince;
+       unsigned int Pressure;
+       std::chrono::steady_clock::time_point LowSince;
+       bool Low;
+       size_t Footprint;
+       size_t PeakFootprint;
+       unsigned int Grows;
+       unsigned int Shrinks;
+};
+
+ElasticSegment*
+AllocateElasticSegment(
+       unsigned int Capacity
+) {
+       BufferT allocation = new char[sizeof(ElasticSegment) + Capacity + 2 * CACHE_LINE];
+
+       size_t address = (size_t)allocation;
+       while (address % CACHE_LINE != 0) {
+              address++;
+       }
+       ElasticSegment* segment = (ElasticSegment*)address;
+       memset((void*)segment, 0, sizeof(ElasticSegment));
+
+       size_t data = address + sizeof(ElasticSegment);
+       while (data % CACHE_LINE != 0) {
+              data++;
+       }
+       segment->Capacity = Capacity;
+       segment->Allocation = allocation;
+       segment->Data = (char*)data;
+
+       return segment;
+}
+
+void
+DeallocateElasticSegment(
+       ElasticSegment* Segment
+) {
+       delete[] Segment->Allocation;
+}
+
+void
+InitElasticRing(
+       ElasticRing* Ring,
+       unsigned int Capacity
+) {
+       ElasticSegment* segment = AllocateElasticSegment(Capacity);
+       Ring->Current[0].store(segment);
+       Ring->Epoch[0].store(1);
+       for (int slot = 0; slot < MAX_ELASTIC_PRODUCERS; slot++) {
+              Ring->Announced[slot][0].store(0);
+       }
+       Ring->NumProducers[0].store(0);
+
+       Ring->Reading = segment;
+       Ring->Retired.clear();
+       Ring->WindowStart = Ring->PressureSince = Ring->LowSince = std::chrono::steady_clock::now();
+       Ring->WindowPeak = 0;
+       Ring->Pressure = 0;
+       Ring->Low = false;
+       Ring->Footprint = Ring->PeakFootprint = Capacity;
+       Ring->Grows = Ring->Shrinks = 0;
+}
+
+//* Only valid once producers and the consumer have stopped.
+void
+DestroyElasticRing(
+       ElasticRing* Ring
+) {
+       for (auto& retired : Ring->Retired) {
+              DeallocateElasticSegment(retired.first);
+       }
+       Ring->Retired.clear();
+
+       ElasticSegment* segment = Ring->Reading;
+       while (segment) {
+              ElasticSegment* next = segment->Next;
+              DeallocateElasticSegment(segment);
+              segment = next;
+       }
+}
+
+//* Returns the slot a producer passes to ElasticInsert, or -1 when MAX_ELASTIC_PRODUCERS are registered.
+int
+ElasticRegisterProducer(
+       ElasticRing* Ring
+) {
+       int slot = Ring->NumProducers[0].fetch_add(1);
+       if (slot >= MAX_ELASTIC_PRODUCERS) {
+              std::cerr << "Elastic ring supports at most " << MAX_ELASTIC_PRODUCERS << " producers" << std::endl;
+              return -1;
+       }
+       return slot;
+}
+
+//* Slot must come from a successful ElasticRegisterProducer; an unregistered producer (-1) is always rejected.
+bool
+ElasticInsert(
+       ElasticRing* Ring,
+       int Slot,
+       const BufferT CopyFrom,
+       MessageSizeT MessageSize
+) {
+       if (Slot < 0 || Slot >= MAX_ELASTIC_PRODUCERS) {
+              return false;
+       }
+
+       MessageSizeT messageBytes = sizeof(MessageSizeT) + MessageSize;
+       while (messageBytes % CACHE_LINE != 0) {
+              messageBytes++;
+       }
+
+       //* Announce before loading Current: a segment retired after this point is not freed until we leave.
+       Ring->Announced[Slot][0].store(Ring->Epoch[0].load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+
+       ElasticSegment* segment;
+       unsigned int forwardTail;
+       unsigned int distance;
+
+       for (;;) {
+              segment = Ring->Current[0].load(std::memory_order_seq_cst);
+              forwardTail = segment->ForwardTail[0].load(std::memory_order_acquire);
+              if (forwardTail & ELASTIC_SEALED) {
+                     //* Sealed after Current moved on; the reload sees the successor.
+                     continue;
+              }
+
+              unsigned int head = segment->Head[0].load(std::memory_order_acquire);
+              distance = (forwardTail - head) & (segment->Capacity - 1);
+              //* Never fill a segment completely, so that a full one is not mistaken for an empty one.
+              if (distance + messageBytes >= segment->Capacity) {
+                     if (!segment->Saturated[0].load(std::memory_order_relaxed)) {
+                            segment->Saturated[0].store(1, std::memory_order_relaxed);
+                     }
+                     Ring->Announced[Slot][0].store(0, std::memory_order_release);
+                     return false;
+              }
+
+              if (segment->ForwardTail[0].compare_exchange_weak(
+                     forwardTail, (forwardTail + messageBytes) & (segment->Capacity - 1), std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                     break;
+              }
+       }
+
+       //* Frames are cache-line aligned, so the header never wraps; the payload may.
+       *((MessageSizeT*)&segment->Data[forwardTail]) = messageBytes;
+       unsigned int payload = forwardTail + sizeof(MessageSizeT);
+       unsigned int firstBytes = std::min<unsigned int>(MessageSize, segment->Capacity - payload);
+       CopyToRing(&segment->Data[payload], CopyFrom, firstBytes, distance);
+       if (firstBytes < MessageSize) {
+              CopyToRing(&segment->Data[0], (const char*)CopyFrom + firstBytes, MessageSize - firstBytes, distance);
+       }
+
+       unsigned int spins = 0;
+       while (segment->Tail[0].load(std::memory_order_acquire) != forwardTail) {
+              if (++spins > ELASTIC_SPIN_LIMIT) {
+                     std::this_thread::yield();
+              }
+       }
+       segment->Tail[0].store((forwardTail + messageBytes) & (segment->Capacity - 1), std::memory_order_release);
+
+       Ring->Announced[Slot][0].store(0, std::memory_order_release);
+       return true;
+}
+
+//* Frees retired segments that no producer can reach any more.
+void
+ReclaimElasticSegments(
+       ElasticRing* Ring
+) {
+       if (Ring->Retired.empty()) {
+              return;
+       }
+       int numProducers = std::min(Ring->NumProducers[0].load(), MAX_ELASTIC_PRODUCERS);
+
+       for (size_t index = 0; index < Ring->Retired.size(); ) {
+              unsigned long long retiredAt = Ring->Retired[index].second;
+              bool reachable = false;
+              for (int slot = 0; slot < numProducers && !reachable; slot++) {
+                     unsigned long long announced = Ring->Announced[slot][0].load(std::memory_order_seq_cst);
+                     reachable = announced && announced <= retiredAt;
+              }
+              if (reachable) {
+                     index++;
+                     continue;
+              }
+
+              Ring->Footprint -= Ring->Retired[index].first->Capacity;
+              DeallocateElasticSegment(Ring->Retired[index].first);
+              Ring->Retired[index] = Ring->Retired.back();
+              Ring->Retired.pop_back();
+       }
+}
+
+//* Publishes a segment of Capacity as Current, then seals the old one. Called by the consumer only.
+void
+ResizeElasticRing(
+       ElasticRing* Ring,
+       unsigned int Capacity
+) {
+       ElasticSegment* current = Ring->Current[0].load(std::memory_order_relaxed);
+       ElasticSegment* successor = AllocateElasticSegment(Capacity);
+       current->Next = successor;
+       Ring->Current[0].store(successor, std::memory_order_seq_cst);
+
+       unsigned int forwardTail = current->ForwardTail[0].load(std::memory_order_relaxed);
+       while (!current->ForwardTail[0].compare_exchange_weak(forwardTail, forwardTail | ELASTIC_SEALED, std::memory_order_acq_rel)) {}
+
+       Ring->Footprint += Capacity;
+       Ring->PeakFootprint = std::max(Ring->PeakFootprint, Ring->Footprint);
+       if (Capacity > current->Capacity) {
+              Ring->Grows++;
+       }
+       else {
+              Ring->Shrinks++;
+       }
+}
+
+//* Samples occupancy in windows of ELASTIC_WINDOW_US. A window is under pressure if producers found the segment full
+//* or the backlog the consumer found reached the high watermark; ELASTIC_GROW_WINDOWS such windows within
+//* ELASTIC_GROW_HORIZON_US double the capacity. Staying below the low watermark for ELASTIC_SHRINK_US halves it.
+//* No resize while a switchover is still draining.
+void
+TrackElasticOccupancy(
+       ElasticRing* Ring,
+       unsigned int Head
+) {
+       ElasticSegment* segment = Ring->Reading;
+       if (segment != Ring->Current[0].load(std::memory_order_relaxed)) {
+              return;
+       }
+
+       unsigned int forwardTail = segment->ForwardTail[0].load(std::memory_order_relaxed) & ~ELASTIC_SEALED;
+       unsigned int occupied = (forwardTail - Head) & (segment->Capacity - 1);
+       Ring->WindowPeak = std::max(Ring->WindowPeak, occupied);
+
+       auto now = std::chrono::steady_clock::now();
+       if (now - Ring->WindowStart < std::chrono::microseconds(ELASTIC_WINDOW_US)) {
+              return;
+       }
+
+       bool saturated = segment->Saturated[0].load(std::memory_order_relaxed);
+       if (saturated) {
+              segment->Saturated[0].store(0, std::memory_order_relaxed);
+       }
+       bool high = saturated || Ring->WindowPeak * (unsigned long long)ELASTIC_SCALE >= segment->Capacity * (unsigned long long)ELASTIC_HIGH;
+       bool low = !saturated && Ring->WindowPeak * (unsigned long long)ELASTIC_SCALE < segment->Capacity * (unsigned long long)ELASTIC_LOW;
+       Ring->WindowStart = now;
+       Ring->WindowPeak = 0;
+
+       if (high) {
+              if (now - Ring->PressureSince > std::chrono::microseconds(ELASTIC_GROW_HORIZON_US)) {
+                     Ring->PressureSince = now;
+                     Ring->Pressure = 0;
+              }
+              Ring->Pressure++;
+       }
+       if (!low || !Ring->Low) {
+              Ring->LowSince = now;
+       }
+       Ring->Low = low;
+
+       if (Ring->Pressure >= ELASTIC_GROW_WINDOWS && segment->Capacity < ELASTIC_MAX) {
+              ResizeElasticRing(Ring, segment->Capacity * 2);
+              Ring->Pressure = 0;
+       }
+       else if (low && segment->Capacity > ELASTIC_MIN && now - Ring->LowSince >= std::chrono::microseconds(ELASTIC_SHRINK_US)) {
+              ResizeElasticRing(Ring, segment->Capacity / 2);
+              Ring->LowSince = now;
+       }
+}
+
+//* Visits up to MaxBatch committed frames in order and calls Visitor(Message, MessageSize); follows switchovers
+//* and drives resizing. Returns the number of frames consumed.
+template <class VisitorT>
+size_t
+ConsumeElastic(
+       ElasticRing* Ring,
+       VisitorT Visitor,
+       size_t MaxBatch
+) {
+       thread_local std::vector<char> scratch;
+       ElasticSegment* segment = Ring->Reading;
+       unsigned int mask = segment->Capacity - 1;
+       unsigned int head = segment->Head[0].load(std::memory_order_relaxed);
+       unsigned int tail = segment->Tail[0].load(std::memory_order_acquire);
+       size_t consumed = 0;
+
+       //* Sampled before draining: what matters is the backlog the consumer finds.
+       TrackElasticOccupancy(Ring, head);
+
+       if (head == tail) {
+              //* A sealed segment is done once everything reserved in it was committed and read.
+              unsigned int forwardTail = segment->ForwardTail[0].load(std::memory_order_acquire);
+              if ((forwardTail & ELASTIC_SEALED) && (forwardTail & ~ELASTIC_SEALED) == head && segment->Next) {
+                     Ring->Reading = segment->Next;
+                     Ring->Retired.push_back({segment, Ring->Epoch[0].fetch_add(1, std::memory_order_seq_cst)});
+              }
+              ReclaimElasticSegments(Ring);
+              return 0;
+       }
+
+       while (head != tail && consumed < MaxBatch) {
+              MessageSizeT frameBytes = *((MessageSizeT*)&segment->Data[head]);
+              unsigned int payload = (head + sizeof(MessageSizeT)) & mask;
+              MessageSizeT messageSize = frameBytes - sizeof(MessageSizeT);
+
+              if (payload + messageSize <= segment->Capacity) {
+                     Visitor((BufferT)&segment->Data[payload], messageSize);
+              }
+              else {
+                     unsigned int firstBytes = segment->Capacity - payload;
+                     scratch.resize(messageSize);
+                     memcpy(scratch.data(), &segment->Data[payload], firstBytes);
+                     memcpy(scratch.data() + firstBytes, &segment->Data[0], messageSize - firstBytes);
+                     Visitor((BufferT)scratch.data(), messageSize);
+              }
+
+              head = (head + frameBytes) & mask;
+              consumed++;
+       }
+       segment->Head[0].store(head, std::memory_order_release);
+
+       return consumed;
+}
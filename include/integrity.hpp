@@ -0,0 +1,222 @@
+#pragma once
+
+#include "common.hpp"
+
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+//* Opt-in integrity envelope: every payload is prefixed with its producer, a per-producer sequence number and
+//* a CRC32C over the rest of the envelope and the payload. The consumer detects lost, duplicated or reordered
+//* and torn messages. CRC32C runs on SSE4.2 or ARMv8 CRC instructions, with a table fallback.
+
+#define CRC32C_POLY         0x82F63B78
+
+
+//* Crc first, so the checksum covers one contiguous range: the rest of the header and the payload.
+struct IntegrityHeaderT {
+       unsigned int Crc;
+       unsigned int Producer;
+       unsigned long long Sequence;
+       unsigned int Length;
+       unsigned int Reserved;
+};
+
+#define INTEGRITY_CRC_OFFSET    sizeof(unsigned int)
+
+enum IntegrityResultT {
+       INTEGRITY_OK,
+       INTEGRITY_LOST,
+       INTEGRITY_DUPLICATE,
+       INTEGRITY_CORRUPT,
+};
+
+//* Producer side: one per producer thread.
+struct IntegritySealerT {
+       unsigned int Producer;
+       unsigned long long NextSequence;
+};
+
+//* Consumer side. A lost count is the size of the gaps seen; duplicated also counts messages that arrive
+//* after a later one of the same producer (reordered).
+struct IntegrityCheckerT {
+       std::vector<unsigned long long> Expected;
+       unsigned long long Passed;
+       unsigned long long Lost;
+       unsigned long long Duplicated;
+       unsigned long long Corrupted;
+};
+
+const unsigned int*
+Crc32cTable() {
+       static unsigned int table[256];
+       static bool built = [] {
+              for (unsigned int i = 0; i < 256; i++) {
+                     unsigned int crc = i;
+                     for (int bit = 0; bit < 8; bit++) {
+                            crc = (crc >> 1) ^ ((crc & 1)? CRC32C_POLY : 0);
+                     }
+                     table[i] = crc;
+              }
+              return true;
+       }();
+       (void)built;
+       return table;
+}
+
+unsigned int
+Crc32cSoftware(
+       unsigned int Crc,
+       const void* Data,
+       size_t Bytes
+) {
+       const unsigned int* table = Crc32cTable();
+       const unsigned char* data = (const unsigned char*)Data;
+       for (size_t i = 0; i < Bytes; i++) {
+              Crc = table[(Crc ^ data[i]) & 0xFF] ^ (Crc >> 8);
+       }
+       return Crc;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2")))
+unsigned int
+Crc32cSse42(
+       unsigned int Crc,
+       const void* Data,
+       size_t Bytes
+) {
+       const char* data = (const char*)Data;
+       unsigned long long crc = Crc;
+       for (; Bytes >= sizeof(unsigned long long); Bytes -= sizeof(unsigned long long), data += sizeof(unsigned long long)) {
+              unsigned long long word;
+              memcpy(&word, data, sizeof(word));
+              crc = _mm_crc32_u64(crc, word);
+       }
+       for (; Bytes; Bytes--, data++) {
+              crc = _mm_crc32_u8((unsigned int)crc, *data);
+       }
+       return (unsigned int)crc;
+}
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+unsigned int
+Crc32cArm(
+       unsigned int Crc,
+       const void* Data,
+       size_t Bytes
+) {
+       const char* data = (const char*)Data;
+       for (; Bytes >= sizeof(unsigned long long); Bytes -= sizeof(unsigned long long), data += sizeof(unsigned long long)) {
+              unsigned long long word;
+              memcpy(&word, data, sizeof(word));
+              Crc = __crc32cd(Crc, word);
+       }
+       for (; Bytes; Bytes--, data++) {
+              Crc = __crc32cb(Crc, *data);
+       }
+       return Crc;
+}
+#endif
+
+//* CRC32C (Castagnoli) of Bytes at Data, on the fastest implementation this CPU and build support.
+unsigned int
+Crc32c(
+       const void* Data,
+       size_t Bytes
+) {
+#if defined(__x86_64__)
+       static const bool hasSse42 = __builtin_cpu_supports("sse4.2");
+       if (hasSse42) {
+              return ~Crc32cSse42(~0u, Data, Bytes);
+       }
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+       return ~Crc32cArm(~0u, Data, Bytes);
+#endif
+       return ~Crc32cSoftware(~0u, Data, Bytes);
+}
+
+void
+InitIntegritySealer(
+       IntegritySealerT* Sealer,
+       unsigned int Producer
+) {
+       Sealer->Producer = Producer;
+       Sealer->NextSequence = 0;
+}
+
+//* Bytes the envelope of a Length byte payload occupies; pass that much to the insert.
+MessageSizeT
+IntegrityMessageBytes(
+       MessageSizeT Length
+) {
+       return sizeof(IntegrityHeaderT) + Length;
+}
+
+//* Writes the envelope and the payload to CopyTo (IntegrityMessageBytes(Length) bytes) under the next sequence number.
+void
+SealMessage(
+       IntegritySealerT* Sealer,
+       const void* Payload,
+       MessageSizeT Length,
+       char* CopyTo
+) {
+       IntegrityHeaderT header = {0, Sealer->Producer, Sealer->NextSequence++, Length, 0};
+       memcpy(CopyTo, &header, sizeof(header));
+       memcpy(CopyTo + sizeof(header), Payload, Length);
+       header.Crc = Crc32c(CopyTo + INTEGRITY_CRC_OFFSET, sizeof(header) - INTEGRITY_CRC_OFFSET + Length);
+       memcpy(CopyTo, &header.Crc, sizeof(header.Crc));
+}
+
+void
+InitIntegrityChecker(
+       IntegrityCheckerT* Checker,
+       unsigned int NumProducers
+) {
+       Checker->Expected.assign(NumProducers, 0);
+       Checker->Passed = 0;
+       Checker->Lost = 0;
+       Checker->Duplicated = 0;
+       Checker->Corrupted = 0;
+}
+
+//* Validates one received message of up to MessageSize bytes (frames may carry padding behind the payload).
+//* A torn frame whose header is still in sequence accounts for its sequence number, so it is not also counted as lost.
+IntegrityResultT
+CheckIntegrity(
+       IntegrityCheckerT* Checker,
+       const char* Message,
+       MessageSizeT MessageSize
+) {
+       IntegrityHeaderT header;
+       if (MessageSize < sizeof(header)) {
+              Checker->Corrupted++;
+              return INTEGRITY_CORRUPT;
+       }
+       memcpy(&header, Message, sizeof(header));
+
+       bool known = header.Producer < Checker->Expected.size();
+       if (!known || header.Length > MessageSize - sizeof(header)
+              || Crc32c(Message + INTEGRITY_CRC_OFFSET, sizeof(header) - INTEGRITY_CRC_OFFSET + header.Length) != header.Crc) {
+              if (known && header.Sequence == Checker->Expected[header.Producer]) {
+                     Checker->Expected[header.Producer]++;
+              }
+              Checker->Corrupted++;
+              return INTEGRITY_CORRUPT;
+       }
+
+       unsigned long long& expected = Checker->Expected[header.Producer];
+       if (header.Sequence < expected) {
+              Checker->Duplicated++;
+              return INTEGRITY_DUPLICATE;
+       }
+       IntegrityResultT result = INTEGRITY_OK;
+       if (header.Sequence > expected) {
+              Checker->Lost += header.Sequence - expected;
+              result = INTEGRITY_LOST;
+       }
+       expected = header.Sequence + 1;
+       Checker->Passed++;
+       return result;
+}
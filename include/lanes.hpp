@@ -0,0 +1,144 @@
+#include "common.hpp"
+#include "tail.hpp"
+
+#define MAX_LANES           4
+//* Consumer passes after which a non-empty lane is served regardless of priority.
+#define STARVATION_BOUND    64
+
+enum LanePolicy {
+       STRICT_PRIORITY,
+       WEIGHTED_FAIR
+};
+
+//* One ring per priority (lane 0 is the most urgent) drained by a single consumer.
+struct LaneGroup {
+       RingBuffer* Lanes[MAX_LANES];
+       BufferT Buffers[MAX_LANES];
+       int NumLanes;
+       LanePolicy Policy;
+       InsertFunctionT Insert;
+       //* Weighted fair: frames credited per round (deficit round robin).
+       unsigned int Weights[MAX_LANES];
+       long long Deficit[MAX_LANES];
+       unsigned int Skipped[MAX_LANES];
+       int Next;
+};
+
+void
+AllocateLaneGroup(
+       LaneGroup* Group,
+       int NumLanes,
+       LanePolicy Policy,
+       const unsigned int* Weights
+) {
+       memset((void*)Group, 0, sizeof(LaneGroup));
+       Group->NumLanes = NumLanes;
+       Group->Policy = Policy;
+       Group->Insert = &TailInsertToMessageBuffer;
+
+       for (int lane = 0; lane < NumLanes; lane++) {
+              Group->Buffers[lane] = new char[sizeof(RingBuffer) + CACHE_LINE];
+              Group->Lanes[lane] = AllocateMessageBuffer(Group->Buffers[lane]);
+              Group->Weights[lane] = (Weights)? Weights[lane] : 1;
+       }
+}
+
+void
+DeallocateLaneGroup(
+       LaneGroup* Group
+) {
+       for (int lane = 0; lane < Group->NumLanes; lane++) {
+              DeallocateMessageBuffer(Group->Lanes[lane]);
+              delete[] Group->Buffers[lane];
+       }
+}
+
+//* Priorities beyond the last lane share the last lane.
+bool
+LaneInsertToMessageBuffer(
+       LaneGroup* Group,
+       int Priority,
+       const BufferT CopyFrom,
+       MessageSizeT MessageSize
+) {
+       int lane = (Priority < Group->NumLanes)? Priority : Group->NumLanes - 1;
+       return Group->Insert(Group->Lanes[lane], CopyFrom, MessageSize);
+}
+
+bool
+LaneHasData(
+       RingBuffer* Ring
+) {
+       return Ring->ForwardTail[0].load(mem_barrier) != Ring->Head[0].load(std::memory_order_relaxed);
+}
+
+//* Strict priority: the most urgent non-empty lane, unless a lower one has been passed over STARVATION_BOUND times.
+int
+PickStrictLane(
+       LaneGroup* Group
+) {
+       int picked = -1;
+
+       for (int lane = 0; lane < Group->NumLanes; lane++) {
+              if (!LaneHasData(Group->Lanes[lane])) {
+                     Group->Skipped[lane] = 0;
+                     continue;
+              }
+              if (picked < 0 || Group->Skipped[lane] >= STARVATION_BOUND) {
+                     if (picked >= 0) Group->Skipped[picked]++;
+                     picked = lane;
+              }
+              else {
+                     Group->Skipped[lane]++;
+              }
+       }
+
+       if (picked >= 0) {
+              Group->Skipped[picked] = 0;
+       }
+       return picked;
+}
+
+//* Drains up to MaxBatch frames from the lane chosen by the group's policy and calls Visitor(Lane, Message, MessageSize).
+//* Returns the number of frames consumed.
+template <class VisitorT>
+size_t
+ConsumeLanes(
+       LaneGroup* Group,
+       VisitorT Visitor,
+       size_t MaxBatch
+) {
+       if (Group->Policy == STRICT_PRIORITY) {
+              int lane = PickStrictLane(Group);
+              if (lane < 0) {
+                     return 0;
+              }
+              return ConsumeMessages(Group->Lanes[lane], [&](BufferT Message, MessageSizeT MessageSize) {
+                     Visitor(lane, Message, MessageSize);
+              }, MaxBatch);
+       }
+
+       //* Deficit round robin: each visit credits the lane its weight, a lane without data loses its credit.
+       for (int visited = 0; visited < Group->NumLanes; visited++) {
+              int lane = Group->Next;
+              Group->Next = (Group->Next + 1) % Group->NumLanes;
+
+              if (!LaneHasData(Group->Lanes[lane])) {
+                     Group->Deficit[lane] = 0;
+                     continue;
+              }
+
+              Group->Deficit[lane] += Group->Weights[lane];
+              size_t budget = std::min<size_t>(Group->Deficit[lane], MaxBatch);
+              size_t consumed = ConsumeMessages(Group->Lanes[lane], [&](BufferT Message, MessageSizeT MessageSize) {
+                     Visitor(lane, Message, MessageSize);
+              }, budget);
+              Group->Deficit[lane] -= consumed;
+
+              if (consumed) {
+                     return consumed;
+              }
+       }
+
+       return 0;
+}
@@ -22,7 +22,7 @@ LockInsertToMessageBuffer(
        //* Simplified to do-while loop.
        do {
               forwardTail = Ring->ForwardTail[0].load(mem_barrier);
-              head = Ring->Head[0];
+              head = Ring->Head[0].load(ORDER_HEAD_LOAD);
               
               if (forwardTail < head) {
                      distance = forwardTail + RING_SIZE - head;
@@ -46,7 +46,7 @@ LockInsertToMessageBuffer(
  
               *((MessageSizeT*)messageAddress) = messageBytes;
  
-              memcpy(messageAddress + sizeof(MessageSizeT), CopyFrom, MessageSize);
+              CopyToRing(messageAddress + sizeof(MessageSizeT), CopyFrom, MessageSize, distance);
        }
        else {
               RingSizeT remainingBytes = RING_SIZE - forwardTail - sizeof(MessageSizeT);
@@ -54,13 +54,13 @@ LockInsertToMessageBuffer(
               *((MessageSizeT*)messageAddress1) = messageBytes;
 
               if (MessageSize <= remainingBytes) {
-                     memcpy(messageAddress1 + sizeof(MessageSizeT), CopyFrom, MessageSize);
+                     CopyToRing(messageAddress1 + sizeof(MessageSizeT), CopyFrom, MessageSize, distance);
               } else {
                      char* messageAddress2 = &Ring->Buffer[0];
                      if (remainingBytes) {
-                            memcpy(messageAddress1 + sizeof(MessageSizeT), CopyFrom, remainingBytes);
+                            CopyToRing(messageAddress1 + sizeof(MessageSizeT), CopyFrom, remainingBytes, distance);
                      }
-                     memcpy(messageAddress2, (const char*)CopyFrom + remainingBytes, MessageSize - remainingBytes);
+                     CopyToRing(messageAddress2, (const char*)CopyFrom + remainingBytes, MessageSize - remainingBytes, distance);
               }
        }
 
@@ -18,7 +18,7 @@ NotifyInsertToMessageBuffer(
 
        do {
               forwardTail = Ring->ForwardTail[0].load(mem_barrier);
-              head = Ring->Head[0];
+              head = Ring->Head[0].load(ORDER_HEAD_LOAD);
               
               if (forwardTail < head) {
                      distance = forwardTail + RING_SIZE - head;
@@ -49,7 +49,7 @@ NotifyInsertToMessageBuffer(
  
               *((MessageSizeT*)messageAddress) = messageBytes;
  
-              memcpy(messageAddress + sizeof(MessageSizeT), CopyFrom, MessageSize);
+              CopyToRing(messageAddress + sizeof(MessageSizeT), CopyFrom, MessageSize, distance);
        }
        else {
               RingSizeT remainingBytes = RING_SIZE - forwardTail - sizeof(MessageSizeT);
@@ -57,13 +57,13 @@ NotifyInsertToMessageBuffer(
               *((MessageSizeT*)messageAddress1) = messageBytes;
 
               if (MessageSize <= remainingBytes) {
-                     memcpy(messageAddress1 + sizeof(MessageSizeT), CopyFrom, MessageSize);
+                     CopyToRing(messageAddress1 + sizeof(MessageSizeT), CopyFrom, MessageSize, distance);
               } else {
                      char* messageAddress2 = &Ring->Buffer[0];
                      if (remainingBytes) {
-                            memcpy(messageAddress1 + sizeof(MessageSizeT), CopyFrom, remainingBytes);
+                            CopyToRing(messageAddress1 + sizeof(MessageSizeT), CopyFrom, remainingBytes, distance);
                      }
-                     memcpy(messageAddress2, (const char*)CopyFrom + remainingBytes, MessageSize - remainingBytes);
+                     CopyToRing(messageAddress2, (const char*)CopyFrom + remainingBytes, MessageSize - remainingBytes, distance);
               }
        }
 
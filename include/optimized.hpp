@@ -1,4 +1,7 @@
+#pragma once
+
 #include "common.hpp"
+#include "admission.hpp"
 
 #define SIZE_MASK (RING_SIZE - 1)
 
@@ -14,17 +17,17 @@ OptimizedInsertToMessageBuffer(
               messageBytes++;
        }
 
-       //* Check if the server is overcommitting (disregard hyperthreading).
-       bool overcommit = gNumProducers > TOTAL_CORES/2;
-       if (overcommit) mtx.lock();
+       //* Limits how many producers contend on the ring once oversubscription shows; free until then.
+       bool admitted = AdmitProducer(Ring);
 
        int forwardTail;
        int head;
        RingSizeT distance = 0;
+       unsigned int casFailures = 0;
 
        do {
-              forwardTail = Ring->ForwardTail[0].load(mem_barrier);
-              head = Ring->Head[0];
+              forwardTail = Ring->ForwardTail[0].load(ORDER_RESERVE);
+              head = Ring->Head[0].load(ORDER_HEAD_LOAD);
               
               if (forwardTail < head) {
                      distance = forwardTail + RING_SIZE - head;
@@ -34,23 +37,26 @@ OptimizedInsertToMessageBuffer(
               }
 
               if (distance >= FORWARD_DEGREE) {
-                     if (overcommit) mtx.unlock();
+                     ReleaseProducer(Ring, admitted, false, false);
+                     TELEMETRY_COUNT(Rejects, 1);
                      return false;
               }
 
               if (messageBytes > RING_SIZE - distance) {
-                     if (overcommit) mtx.unlock();
+                     ReleaseProducer(Ring, admitted, false, false);
+                     TELEMETRY_COUNT(Rejects, 1);
                      return false;
               }
        } while (Ring->ForwardTail[0].compare_exchange_weak(
-              forwardTail, (forwardTail + messageBytes) % RING_SIZE, mem_barrier, mem_barrier) == false);
+              forwardTail, (forwardTail + messageBytes) % RING_SIZE, ORDER_RESERVE, std::memory_order_relaxed) == false && ++casFailures);
+       TRACE_EVENT(TRACE_RESERVE, forwardTail, messageBytes);
        
        if (forwardTail + messageBytes <= RING_SIZE) {
               char* messageAddress = &Ring->Buffer[forwardTail];
  
               *((MessageSizeT*)messageAddress) = messageBytes;
  
-              memcpy(messageAddress + sizeof(MessageSizeT), CopyFrom, MessageSize);
+              CopyToRing(messageAddress + sizeof(MessageSizeT), CopyFrom, MessageSize, distance);
        }
        else {
               RingSizeT remainingBytes = RING_SIZE - forwardTail - sizeof(MessageSizeT);
@@ -58,30 +64,31 @@ OptimizedInsertToMessageBuffer(
               *((MessageSizeT*)messageAddress1) = messageBytes;
 
               if (MessageSize <= remainingBytes) {
-                     memcpy(messageAddress1 + sizeof(MessageSizeT), CopyFrom, MessageSize);
+                     CopyToRing(messageAddress1 + sizeof(MessageSizeT), CopyFrom, MessageSize, distance);
               } else {
                      char* messageAddress2 = &Ring->Buffer[0];
                      if (remainingBytes) {
-                            memcpy(messageAddress1 + sizeof(MessageSizeT), CopyFrom, remainingBytes);
+                            CopyToRing(messageAddress1 + sizeof(MessageSizeT), CopyFrom, remainingBytes, distance);
                      }
-                     memcpy(messageAddress2, (const char*)CopyFrom + remainingBytes, MessageSize - remainingBytes);
+                     CopyToRing(messageAddress2, (const char*)CopyFrom + remainingBytes, MessageSize - remainingBytes, distance);
               }
        }
 
-       while (Ring->Tail != forwardTail) {
-              if (gNumProducers >= TOTAL_CORES/4) {
+       TRACE_EVENT(TRACE_WAIT, forwardTail, 0);
+       //* A long wait means a predecessor lost its core; yield so it can finish.
+       unsigned int commitSpins = 0;
+       while (Ring->Tail.load(ORDER_COMMIT_WAIT) != forwardTail) {
+              if (++commitSpins > COMMIT_SPIN_LIMIT) {
                      std::this_thread::yield();
               }
        }
 
-#ifdef ARM
-//* Prevents the compiler from publishing the commit before the stores above on arm.
-       std::atomic_thread_fence(std::memory_order_release);
-#endif
-       Ring->Tail = (forwardTail + messageBytes) & SIZE_MASK;
+       Ring->Tail.store((forwardTail + messageBytes) & SIZE_MASK, ORDER_COMMIT);
+       TRACE_EVENT(TRACE_COMMIT, forwardTail, messageBytes);
 
-       if (overcommit) mtx.unlock();
+       ReleaseProducer(Ring, admitted, true, casFailures >= CAS_FAILURE_LIMIT || commitSpins > COMMIT_SPIN_LIMIT);
 
+       TELEMETRY_COUNT(Inserts, 1);
        return true;
 }
  
\ No newline at end of file
@@ -0,0 +1,242 @@
+#pragma once
+
+#include "common.hpp"
+
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cerrno>
+
+//* Low-frequency sampler for a ring (-DTELEMETRY builds): reads the ring indices and the telemetry counters,
+//* never writes a ring cache line, and publishes gauges and rates to a shared-memory stats page and to a
+//* Prometheus text file (for the node_exporter textfile collector).
+
+#define TELEMETRY_INTERVAL_MS   100
+//* Samples between two rewrites of the Prometheus file.
+#define TELEMETRY_EXPORT_EVERY  10
+#define TELEMETRY_SHM_NAME      "/ringbuffer-telemetry"
+#define TELEMETRY_PROM_PATH     "data/ringbuffer.prom"
+#define TELEMETRY_MAGIC         0x4d4c4554
+#define TELEMETRY_VERSION       1
+
+
+//* The shared-memory stats page. The sampler makes Sequence odd while it writes; a reader retries
+//* until it saw the same even Sequence before and after copying (ReadTelemetryPage).
+struct TelemetryPage {
+       unsigned int Magic;
+       unsigned int Version;
+       Atomic<unsigned int> Sequence;
+       unsigned int IntervalMs;
+       unsigned long long TimestampNs;
+
+       //* Gauges, in bytes: reserved but not consumed (ForwardTail - Head), reserved but not committed (ForwardTail - Tail).
+       long long Occupancy;
+       long long CommitLag;
+       long long Capacity;
+
+       //* Per second over the last interval.
+       double InsertRate;
+       double RejectRate;
+       double DrainBytesRate;
+       //* Rejected share of insert attempts over the last interval.
+       double RejectRatio;
+
+       unsigned long long Inserts;
+       unsigned long long Rejects;
+       unsigned long long DrainedBytes;
+};
+
+struct TelemetrySampler {
+       RingBuffer* Ring;
+       TelemetryPage* Page;
+       int PageFd;
+       const char* ShmName;
+       const char* PromPath;
+       std::atomic<bool> Stop;
+       std::thread Thread;
+};
+
+long long
+RingDistance(
+       int From,
+       int To
+) {
+       return (To >= From)? To - From : To + RING_SIZE - From;
+}
+
+void
+PublishTelemetryPage(
+       TelemetryPage* Page,
+       const TelemetryPage& Sample
+) {
+       unsigned int sequence = Page->Sequence.load(std::memory_order_relaxed);
+       Page->Sequence.store(sequence + 1, std::memory_order_relaxed);
+       std::atomic_thread_fence(std::memory_order_release);
+
+       Page->IntervalMs = Sample.IntervalMs;
+       Page->TimestampNs = Sample.TimestampNs;
+       Page->Occupancy = Sample.Occupancy;
+       Page->CommitLag = Sample.CommitLag;
+       Page->Capacity = Sample.Capacity;
+       Page->InsertRate = Sample.InsertRate;
+       Page->RejectRate = Sample.RejectRate;
+       Page->DrainBytesRate = Sample.DrainBytesRate;
+       Page->RejectRatio = Sample.RejectRatio;
+       Page->Inserts = Sample.Inserts;
+       Page->Rejects = Sample.Rejects;
+       Page->DrainedBytes = Sample.DrainedBytes;
+
+       Page->Sequence.store(sequence + 2, std::memory_order_release);
+}
+
+//* Copies a consistent snapshot of Page to Out; for readers in other processes.
+void
+ReadTelemetryPage(
+       const TelemetryPage* Page,
+       TelemetryPage* Out
+) {
+       for (;;) {
+              unsigned int before = Page->Sequence.load(std::memory_order_acquire);
+              if (before & 1) {
+                     continue;
+              }
+              memcpy((void*)Out, (const void*)Page, sizeof(TelemetryPage));
+              std::atomic_thread_fence(std::memory_order_acquire);
+              if (Page->Sequence.load(std::memory_order_relaxed) == before) {
+                     return;
+              }
+       }
+}
+
+//* Written to a temporary file and renamed, so a scraper never reads half a file.
+void
+ExportPrometheus(
+       const char* Path,
+       const TelemetryPage& Sample
+) {
+       std::string temporary = std::string(Path) + ".tmp";
+       FILE* file = fopen(temporary.c_str(), "w");
+       if (!file) {
+              return;
+       }
+       fprintf(file, "# HELP ringbuffer_occupancy_bytes Reserved but not yet consumed bytes (ForwardTail - Head).\n"
+                     "# TYPE ringbuffer_occupancy_bytes gauge\nringbuffer_occupancy_bytes %lld\n", Sample.Occupancy);
+       fprintf(file, "# HELP ringbuffer_commit_lag_bytes Reserved but not yet committed bytes (ForwardTail - Tail).\n"
+                     "# TYPE ringbuffer_commit_lag_bytes gauge\nringbuffer_commit_lag_bytes %lld\n", Sample.CommitLag);
+       fprintf(file, "# HELP ringbuffer_capacity_bytes Ring size.\n"
+                     "# TYPE ringbuffer_capacity_bytes gauge\nringbuffer_capacity_bytes %lld\n", Sample.Capacity);
+       fprintf(file, "# HELP ringbuffer_inserts_total Successful inserts.\n"
+                     "# TYPE ringbuffer_inserts_total counter\nringbuffer_inserts_total %llu\n", Sample.Inserts);
+       fprintf(file, "# HELP ringbuffer_rejects_total Inserts refused because the ring was full.\n"
+                     "# TYPE ringbuffer_rejects_total counter\nringbuffer_rejects_total %llu\n", Sample.Rejects);
+       fprintf(file, "# HELP ringbuffer_drained_bytes_total Bytes handed back to the producers by the consumer.\n"
+                     "# TYPE ringbuffer_drained_bytes_total counter\nringbuffer_drained_bytes_total %llu\n", Sample.DrainedBytes);
+       fprintf(file, "# HELP ringbuffer_reject_ratio Rejected share of insert attempts over the last interval.\n"
+                     "# TYPE ringbuffer_reject_ratio gauge\nringbuffer_reject_ratio %g\n", Sample.RejectRatio);
+       fclose(file);
+       rename(temporary.c_str(), Path);
+}
+
+void
+RunTelemetrySampler(
+       TelemetrySampler* Sampler
+) {
+       RingBuffer* ring = Sampler->Ring;
+       TelemetryPage previous;
+       memset((void*)&previous, 0, sizeof(previous));
+       auto startTime = std::chrono::steady_clock::now();
+
+       for (unsigned int round = 1; !Sampler->Stop.load(std::memory_order_relaxed); round++) {
+              std::this_thread::sleep_for(std::chrono::milliseconds(TELEMETRY_INTERVAL_MS));
+
+              TelemetryPage sample;
+              memset((void*)&sample, 0, sizeof(sample));
+              sample.IntervalMs = TELEMETRY_INTERVAL_MS;
+              sample.TimestampNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count();
+
+              //* Relaxed loads: the gauges are estimates and must not order anything in the ring.
+              int tail = ring->Tail.load(std::memory_order_relaxed);
+              int forwardTail = ring->ForwardTail[0].load(std::memory_order_relaxed);
+              int committed = (tail < 0)? ring->SafeTail[0].load(std::memory_order_relaxed) : tail;
+              sample.Occupancy = RingDistance(ring->Head[0].load(std::memory_order_relaxed), forwardTail);
+              sample.CommitLag = RingDistance(committed, forwardTail);
+              sample.Capacity = RING_SIZE;
+
+              sample.Inserts = TelemetryTotal(&TelemetrySlotT::Inserts);
+              sample.Rejects = TelemetryTotal(&TelemetrySlotT::Rejects);
+              sample.DrainedBytes = TelemetryTotal(&TelemetrySlotT::DrainedBytes);
+
+              double seconds = (sample.TimestampNs - previous.TimestampNs) / 1e9;
+              unsigned long long inserts = sample.Inserts - previous.Inserts;
+              unsigned long long rejects = sample.Rejects - previous.Rejects;
+              sample.InsertRate = inserts / seconds;
+              sample.RejectRate = rejects / seconds;
+              sample.DrainBytesRate = (sample.DrainedBytes - previous.DrainedBytes) / seconds;
+              sample.RejectRatio = (inserts + rejects)? (double)rejects / (inserts + rejects) : 0;
+
+              if (Sampler->Page) {
+                     PublishTelemetryPage(Sampler->Page, sample);
+              }
+              if (Sampler->PromPath && round % TELEMETRY_EXPORT_EVERY == 0) {
+                     ExportPrometheus(Sampler->PromPath, sample);
+              }
+              memcpy((void*)&previous, (const void*)&sample, sizeof(sample));
+       }
+
+       //* Leave the final state behind for the next scrape.
+       if (Sampler->PromPath && previous.TimestampNs) {
+              ExportPrometheus(Sampler->PromPath, previous);
+       }
+}
+
+//* Resets the counters and starts sampling Ring. Without a stats page (ShmName null or shm unavailable)
+//* only the Prometheus file is written, and vice versa.
+void
+StartTelemetry(
+       TelemetrySampler* Sampler,
+       RingBuffer* Ring,
+       const char* ShmName,
+       const char* PromPath
+) {
+       Sampler->Ring = Ring;
+       Sampler->Page = nullptr;
+       Sampler->PageFd = -1;
+       Sampler->ShmName = ShmName;
+       Sampler->PromPath = PromPath;
+       Sampler->Stop.store(false);
+       TelemetryReset();
+
+       if (ShmName) {
+              int fd = shm_open(ShmName, O_RDWR | O_CREAT, 0600);
+              if (fd < 0 || ftruncate(fd, sizeof(TelemetryPage)) < 0) {
+                     std::cerr << "Error opening stats page " << ShmName << ": " << strerror(errno) << std::endl;
+              }
+              else {
+                     void* page = mmap(nullptr, sizeof(TelemetryPage), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+                     if (page != MAP_FAILED) {
+                            Sampler->Page = (TelemetryPage*)page;
+                            Sampler->Page->Magic = TELEMETRY_MAGIC;
+                            Sampler->Page->Version = TELEMETRY_VERSION;
+                     }
+              }
+              Sampler->PageFd = fd;
+       }
+
+       Sampler->Thread = std::thread(RunTelemetrySampler, Sampler);
+}
+
+//* Stops the sampler. The stats page stays behind for readers; shm_unlink(ShmName) removes it.
+void
+StopTelemetry(
+       TelemetrySampler* Sampler
+) {
+       Sampler->Stop.store(true);
+       Sampler->Thread.join();
+       if (Sampler->Page) {
+              munmap(Sampler->Page, sizeof(TelemetryPage));
+       }
+       if (Sampler->PageFd >= 0) {
+              close(Sampler->PageFd);
+       }
+}
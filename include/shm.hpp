@@ -0,0 +1,224 @@
+#include "common.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <cerrno>
+
+#define SHM_MAGIC           0x474e4952
+#define SHM_VERSION         1
+#define MAX_PEERS           32
+#define PEER_TIMEOUT_MS     1000
+
+
+//* Placed in front of the ring so an attaching process can check it was built with the same layout.
+struct SharedRingHeader {
+       Atomic<unsigned int> Magic;
+       unsigned int Version;
+       unsigned int Capacity;
+       unsigned int Framing;
+       unsigned int ForwardDegree;
+       unsigned int RingBytes;
+       int CreatorPid;
+       Atomic<int> PeerPid[MAX_PEERS];
+       Atomic<long> PeerBeat[MAX_PEERS];
+};
+
+//* Per-process handle of a mapped ring.
+struct SharedMessageBuffer {
+       SharedRingHeader* Header;
+       RingBuffer* Ring;
+       size_t MappedBytes;
+       int Fd;
+       int Slot;
+};
+
+size_t
+SharedRingOffset() {
+       return (sizeof(SharedRingHeader) + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+}
+
+long
+SharedClockMs() {
+       return std::chrono::duration_cast<std::chrono::milliseconds>(
+              std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void
+SharedHeartbeat(
+       SharedMessageBuffer* Shared
+) {
+       Shared->Header->PeerBeat[Shared->Slot].store(SharedClockMs(), std::memory_order_relaxed);
+}
+
+//* Claims a peer slot for this process; -1 when all slots are taken.
+int
+SharedRegisterPeer(
+       SharedMessageBuffer* Shared
+) {
+       for (int slot = 0; slot < MAX_PEERS; slot++) {
+              int expected = 0;
+              if (Shared->Header->PeerPid[slot].compare_exchange_strong(expected, getpid())) {
+                     Shared->Slot = slot;
+                     SharedHeartbeat(Shared);
+                     return slot;
+              }
+       }
+       return -1;
+}
+
+//* A peer is dead when its process is gone or it has not beaten for PEER_TIMEOUT_MS.
+//* Returns the number of registered peers (other than the caller) that are dead.
+int
+SharedDeadPeers(
+       SharedMessageBuffer* Shared
+) {
+       int dead = 0;
+       long now = SharedClockMs();
+
+       for (int slot = 0; slot < MAX_PEERS; slot++) {
+              int pid = Shared->Header->PeerPid[slot].load(std::memory_order_acquire);
+              if (pid == 0 || slot == Shared->Slot) {
+                     continue;
+              }
+              bool exists = kill(pid, 0) == 0 || errno == EPERM;
+              if (!exists || now - Shared->Header->PeerBeat[slot].load(std::memory_order_relaxed) > PEER_TIMEOUT_MS) {
+                     dead++;
+              }
+       }
+
+       return dead;
+}
+
+bool
+MapSharedMessageBuffer(
+       SharedMessageBuffer* Shared,
+       int Fd
+) {
+       Shared->Fd = Fd;
+       Shared->Slot = -1;
+       Shared->MappedBytes = SharedRingOffset() + sizeof(RingBuffer);
+
+       void* address = mmap(nullptr, Shared->MappedBytes, PROT_READ | PROT_WRITE, MAP_SHARED, Fd, 0);
+       if (address == MAP_FAILED) {
+              std::cerr << "Error mapping shared ring: " << strerror(errno) << std::endl;
+              return false;
+       }
+
+       Shared->Header = (SharedRingHeader*)address;
+       Shared->Ring = (RingBuffer*)((char*)address + SharedRingOffset());
+
+       return true;
+}
+
+//* Name == nullptr creates an anonymous memfd ring, to be shared by fork or by passing Shared->Fd.
+bool
+CreateSharedMessageBuffer(
+       const char* Name,
+       SharedMessageBuffer* Shared
+) {
+       int fd = (Name)? shm_open(Name, O_CREAT | O_EXCL | O_RDWR, 0600) : (int)syscall(SYS_memfd_create, "ringbuffer", 0);
+       if (fd < 0) {
+              std::cerr << "Error creating shared ring: " << strerror(errno) << std::endl;
+              return false;
+       }
+
+       if (ftruncate(fd, SharedRingOffset() + sizeof(RingBuffer)) != 0 || !MapSharedMessageBuffer(Shared, fd)) {
+              close(fd);
+              if (Name) shm_unlink(Name);
+              return false;
+       }
+
+       //* The mapping is page-aligned, so the ring needs no extra alignment.
+       AllocateMessageBuffer((BufferT)Shared->Ring);
+       SharedRingHeader* header = Shared->Header;
+       header->Version = SHM_VERSION;
+       header->Capacity = RING_SIZE;
+       header->Framing = CACHE_LINE;
+       header->ForwardDegree = FORWARD_DEGREE;
+       header->RingBytes = sizeof(RingBuffer);
+       header->CreatorPid = getpid();
+       //* Published last: attachers treat a missing magic as "not ready".
+       header->Magic.store(SHM_MAGIC, std::memory_order_release);
+
+       SharedRegisterPeer(Shared);
+
+       return true;
+}
+
+bool
+AttachSharedMessageBufferFd(
+       int Fd,
+       SharedMessageBuffer* Shared
+) {
+       struct stat status;
+       if (fstat(Fd, &status) != 0 || (size_t)status.st_size != SharedRingOffset() + sizeof(RingBuffer)) {
+              std::cerr << "Shared ring size mismatch" << std::endl;
+              close(Fd);
+              return false;
+       }
+
+       if (!MapSharedMessageBuffer(Shared, Fd)) {
+              close(Fd);
+              return false;
+       }
+
+       SharedRingHeader* header = Shared->Header;
+       if (header->Magic.load(std::memory_order_acquire) != SHM_MAGIC
+              || header->Version != SHM_VERSION
+              || header->Capacity != RING_SIZE
+              || header->Framing != CACHE_LINE
+              || header->ForwardDegree != FORWARD_DEGREE
+              || header->RingBytes != sizeof(RingBuffer))
+       {
+              std::cerr << "Shared ring header mismatch (version " << header->Version << ", capacity " << header->Capacity << ")" << std::endl;
+              munmap(header, Shared->MappedBytes);
+              close(Fd);
+              return false;
+       }
+
+       if (SharedRegisterPeer(Shared) < 0) {
+              std::cerr << "Shared ring has no free peer slot" << std::endl;
+              munmap(header, Shared->MappedBytes);
+              close(Fd);
+              return false;
+       }
+
+       return true;
+}
+
+bool
+AttachSharedMessageBuffer(
+       const char* Name,
+       SharedMessageBuffer* Shared
+) {
+       int fd = shm_open(Name, O_RDWR, 0600);
+       if (fd < 0) {
+              std::cerr << "Error attaching shared ring " << Name << ": " << strerror(errno) << std::endl;
+              return false;
+       }
+
+       return AttachSharedMessageBufferFd(fd, Shared);
+}
+
+//* Releases this process's peer slot and mapping; the creator also removes the name.
+void
+DetachSharedMessageBuffer(
+       SharedMessageBuffer* Shared,
+       const char* Name
+) {
+       bool creator = Shared->Header->CreatorPid == getpid();
+
+       if (Shared->Slot >= 0) {
+              Shared->Header->PeerPid[Shared->Slot].store(0, std::memory_order_release);
+       }
+       munmap(Shared->Header, Shared->MappedBytes);
+       close(Shared->Fd);
+
+       if (creator && Name) {
+              shm_unlink(Name);
+       }
+}
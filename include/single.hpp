@@ -8,7 +8,7 @@ InsertToMessageBuffer(
        MessageSizeT MessageSize
 ) {
        int forwardTail = Ring->ForwardTail[0];
-       int head = Ring->Head[0];
+       int head = Ring->Head[0].load(ORDER_HEAD_LOAD);
        RingSizeT distance = 0;
 
        if (forwardTail < head) {
@@ -33,10 +33,10 @@ InsertToMessageBuffer(
  
        while (Ring->ForwardTail[0].compare_exchange_weak(forwardTail, (forwardTail + messageBytes) % RING_SIZE) == false) {
               forwardTail = Ring->ForwardTail[0];
-              head = Ring->Head[0];
+              head = Ring->Head[0].load(ORDER_HEAD_LOAD);
 
               forwardTail = Ring->ForwardTail[0];
-              head = Ring->Head[0];
+              head = Ring->Head[0].load(ORDER_HEAD_LOAD);
 
               if (forwardTail <= head) {
                      distance = forwardTail + RING_SIZE - head;
@@ -59,7 +59,7 @@ InsertToMessageBuffer(
  
               *((MessageSizeT*)messageAddress) = messageBytes;
  
-              memcpy(messageAddress + sizeof(MessageSizeT), CopyFrom, MessageSize);
+              CopyToRing(messageAddress + sizeof(MessageSizeT), CopyFrom, MessageSize, distance);
  
               int safeTail = Ring->SafeTail[0];
               while (Ring->SafeTail[0].compare_exchange_weak(safeTail, (safeTail + messageBytes) % RING_SIZE) == false) {
@@ -72,13 +72,13 @@ InsertToMessageBuffer(
               *((MessageSizeT*)messageAddress1) = messageBytes;
 
               if (MessageSize <= remainingBytes) {
-                     memcpy(messageAddress1 + sizeof(MessageSizeT), CopyFrom, MessageSize);
+                     CopyToRing(messageAddress1 + sizeof(MessageSizeT), CopyFrom, MessageSize, distance);
               } else {
                      char* messageAddress2 = &Ring->Buffer[0];
                      if (remainingBytes) {
-                            memcpy(messageAddress1 + sizeof(MessageSizeT), CopyFrom, remainingBytes);
+                            CopyToRing(messageAddress1 + sizeof(MessageSizeT), CopyFrom, remainingBytes, distance);
                      }
-                     memcpy(messageAddress2, (const char*)CopyFrom + remainingBytes, MessageSize - remainingBytes);
+                     CopyToRing(messageAddress2, (const char*)CopyFrom + remainingBytes, MessageSize - remainingBytes, distance);
               }
  
               int safeTail = Ring->SafeTail[0];
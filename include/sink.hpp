@@ -0,0 +1,299 @@
+#include "common.hpp"
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+
+#define SINK_DEPTH          64
+#define SINK_CHUNK          262144
+
+
+//* One in-flight write: the ring range it covers and whether the kernel has completed it.
+struct SinkWrite {
+       int EndHead;
+       unsigned int Bytes;
+       bool Done;
+       struct iovec Iov;
+};
+
+//* Streams committed ring regions to a file through io_uring, straight from the ring memory.
+//* Head only moves past a region once its write completed, so producers never overwrite in-flight bytes.
+//* Without io_uring (old kernel, seccomp) it falls back to pwrite from the ring.
+struct RingSink {
+       int UringFd;
+       int FileFd;
+       bool Registered;
+       unsigned long long FileOffset;
+       int SubmittedTail;
+
+       unsigned int* SqHead;
+       unsigned int* SqTail;
+       unsigned int* SqMask;
+       unsigned int* SqArray;
+       struct io_uring_sqe* Sqes;
+       unsigned int* CqHead;
+       unsigned int* CqTail;
+       unsigned int* CqMask;
+       struct io_uring_cqe* Cqes;
+       void* SqRing;
+       void* CqRing;
+       size_t SqRingBytes;
+       size_t CqRingBytes;
+       size_t SqesBytes;
+
+       SinkWrite Writes[SINK_DEPTH];
+       unsigned int WritesHead;
+       unsigned int WritesTail;
+       unsigned int Pending;
+};
+
+bool
+SetupSinkUring(
+       RingSink* Sink,
+       RingBuffer* Ring
+) {
+       struct io_uring_params params;
+       memset(&params, 0, sizeof(params));
+
+       int fd = (int)syscall(__NR_io_uring_setup, SINK_DEPTH, &params);
+       if (fd < 0) {
+              return false;
+       }
+
+       Sink->SqRingBytes = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+       Sink->CqRingBytes = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+       bool singleMap = params.features & IORING_FEAT_SINGLE_MMAP;
+       if (singleMap) {
+              Sink->SqRingBytes = Sink->CqRingBytes = std::max(Sink->SqRingBytes, Sink->CqRingBytes);
+       }
+
+       Sink->SqRing = mmap(nullptr, Sink->SqRingBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+       Sink->CqRing = (singleMap)? Sink->SqRing :
+              mmap(nullptr, Sink->CqRingBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+       Sink->SqesBytes = params.sq_entries * sizeof(struct io_uring_sqe);
+       Sink->Sqes = (struct io_uring_sqe*)mmap(nullptr, Sink->SqesBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+       if (Sink->SqRing == MAP_FAILED || Sink->CqRing == MAP_FAILED || Sink->Sqes == MAP_FAILED) {
+              //* Unmap whichever mappings succeeded; with a single map the CQ ring is the SQ ring.
+              if (Sink->Sqes != MAP_FAILED) {
+                     munmap(Sink->Sqes, Sink->SqesBytes);
+              }
+              if (Sink->CqRing != MAP_FAILED && Sink->CqRing != Sink->SqRing) {
+                     munmap(Sink->CqRing, Sink->CqRingBytes);
+              }
+              if (Sink->SqRing != MAP_FAILED) {
+                     munmap(Sink->SqRing, Sink->SqRingBytes);
+              }
+              close(fd);
+              return false;
+       }
+
+       char* sq = (char*)Sink->SqRing;
+       char* cq = (char*)Sink->CqRing;
+       Sink->SqHead = (unsigned int*)(sq + params.sq_off.head);
+       Sink->SqTail = (unsigned int*)(sq + params.sq_off.tail);
+       Sink->SqMask = (unsigned int*)(sq + params.sq_off.ring_mask);
+       Sink->SqArray = (unsigned int*)(sq + params.sq_off.array);
+       Sink->CqHead = (unsigned int*)(cq + params.cq_off.head);
+       Sink->CqTail = (unsigned int*)(cq + params.cq_off.tail);
+       Sink->CqMask = (unsigned int*)(cq + params.cq_off.ring_mask);
+       Sink->Cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+       Sink->UringFd = fd;
+
+       //* The whole ring buffer is one fixed buffer; this needs enough RLIMIT_MEMLOCK, otherwise plain writes are used.
+       struct iovec ringIov = {Ring->Buffer, RING_SIZE};
+       Sink->Registered = syscall(__NR_io_uring_register, fd, IORING_REGISTER_BUFFERS, &ringIov, 1) == 0;
+
+       return true;
+}
+
+bool
+OpenRingSink(
+       RingSink* Sink,
+       RingBuffer* Ring,
+       const char* Path,
+       bool UseUring
+) {
+       memset((void*)Sink, 0, sizeof(RingSink));
+       Sink->UringFd = -1;
+       Sink->SubmittedTail = Ring->Head[0].load(std::memory_order_relaxed);
+
+       Sink->FileFd = open(Path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+       if (Sink->FileFd < 0) {
+              std::cerr << "Error opening sink " << Path << ": " << strerror(errno) << std::endl;
+              return false;
+       }
+
+       if (UseUring && !SetupSinkUring(Sink, Ring)) {
+              std::cerr << "io_uring unavailable, falling back to pwrite" << std::endl;
+       }
+
+       return true;
+}
+
+void
+CloseRingSink(
+       RingSink* Sink
+) {
+       if (Sink->UringFd >= 0) {
+              munmap(Sink->Sqes, Sink->SqesBytes);
+              if (Sink->CqRing != Sink->SqRing) {
+                     munmap(Sink->CqRing, Sink->CqRingBytes);
+              }
+              munmap(Sink->SqRing, Sink->SqRingBytes);
+              close(Sink->UringFd);
+       }
+       close(Sink->FileFd);
+}
+
+//* Queues one write of Bytes at ring offset Offset; the caller submits the batch.
+void
+QueueSinkWrite(
+       RingSink* Sink,
+       RingBuffer* Ring,
+       int Offset,
+       unsigned int Bytes
+) {
+       unsigned int slot = Sink->WritesTail % SINK_DEPTH;
+       SinkWrite* write = &Sink->Writes[slot];
+       write->EndHead = (Offset + Bytes) % RING_SIZE;
+       write->Bytes = Bytes;
+       write->Done = false;
+       write->Iov.iov_base = &Ring->Buffer[Offset];
+       write->Iov.iov_len = Bytes;
+
+       unsigned int tail = *Sink->SqTail;
+       unsigned int index = tail & *Sink->SqMask;
+       struct io_uring_sqe* sqe = &Sink->Sqes[index];
+       memset(sqe, 0, sizeof(*sqe));
+       sqe->fd = Sink->FileFd;
+       sqe->off = Sink->FileOffset;
+       sqe->user_data = slot;
+       if (Sink->Registered) {
+              sqe->opcode = IORING_OP_WRITE_FIXED;
+              sqe->addr = (unsigned long long)write->Iov.iov_base;
+              sqe->len = Bytes;
+              sqe->buf_index = 0;
+       }
+       else {
+              sqe->opcode = IORING_OP_WRITEV;
+              sqe->addr = (unsigned long long)&write->Iov;
+              sqe->len = 1;
+       }
+       Sink->SqArray[index] = index;
+       __atomic_store_n(Sink->SqTail, tail + 1, __ATOMIC_RELEASE);
+
+       Sink->FileOffset += Bytes;
+       Sink->WritesTail++;
+       Sink->Pending++;
+}
+
+//* Marks finished writes and moves Head over the completed prefix. Returns false on a failed write.
+bool
+ReapSinkWrites(
+       RingSink* Sink,
+       RingBuffer* Ring
+) {
+       unsigned int head = *Sink->CqHead;
+       unsigned int tail = __atomic_load_n(Sink->CqTail, __ATOMIC_ACQUIRE);
+
+       for (; head != tail; head++) {
+              struct io_uring_cqe* cqe = &Sink->Cqes[head & *Sink->CqMask];
+              SinkWrite* write = &Sink->Writes[cqe->user_data];
+              if (cqe->res != (int)write->Bytes) {
+                     std::cerr << "Sink write failed: " << ((cqe->res < 0)? strerror(-cqe->res) : "short write") << std::endl;
+                     return false;
+              }
+              write->Done = true;
+       }
+       __atomic_store_n(Sink->CqHead, head, __ATOMIC_RELEASE);
+
+       int newHead = -1;
+       while (Sink->WritesHead != Sink->WritesTail && Sink->Writes[Sink->WritesHead % SINK_DEPTH].Done) {
+              newHead = Sink->Writes[Sink->WritesHead % SINK_DEPTH].EndHead;
+              Sink->WritesHead++;
+       }
+       if (newHead >= 0) {
+              ReleaseToProducers(Ring, newHead);
+       }
+
+       return true;
+}
+
+//* Submits the newly committed bytes in up to SINK_CHUNK pieces with one io_uring_enter and reaps completions.
+//* Returns the bytes submitted, or -1 on a write error.
+long long
+SinkMessageBuffer(
+       RingSink* Sink,
+       RingBuffer* Ring
+) {
+       int safeTail = CommittedTail(Ring);
+       int forwardTail = Ring->ForwardTail[0].load(mem_barrier);
+       long long submitted = 0;
+
+       if (Sink->UringFd < 0) {
+              //* Fallback: synchronous write straight from the ring, Head moves once it returned.
+              if (forwardTail != safeTail || safeTail == Sink->SubmittedTail) {
+                     return 0;
+              }
+              int end = (safeTail > Sink->SubmittedTail)? safeTail : RING_SIZE;
+              ssize_t written = pwrite(Sink->FileFd, &Ring->Buffer[Sink->SubmittedTail], end - Sink->SubmittedTail, Sink->FileOffset);
+              if (written <= 0) {
+                     std::cerr << "Sink write failed: " << strerror(errno) << std::endl;
+                     return -1;
+              }
+              Sink->FileOffset += written;
+              Sink->SubmittedTail = (Sink->SubmittedTail + written) % RING_SIZE;
+              ReleaseToProducers(Ring, Sink->SubmittedTail);
+              return written;
+       }
+
+       if (forwardTail == safeTail) {
+              while (Sink->SubmittedTail != safeTail && Sink->WritesTail - Sink->WritesHead < SINK_DEPTH) {
+                     int end = (safeTail > Sink->SubmittedTail)? safeTail : RING_SIZE;
+                     unsigned int bytes = std::min(end - Sink->SubmittedTail, SINK_CHUNK);
+                     QueueSinkWrite(Sink, Ring, Sink->SubmittedTail, bytes);
+                     Sink->SubmittedTail = (Sink->SubmittedTail + bytes) % RING_SIZE;
+                     submitted += bytes;
+              }
+       }
+
+       //* Block for a completion only when nothing new could be queued.
+       unsigned int waitFor = (!submitted && Sink->WritesHead != Sink->WritesTail)? 1 : 0;
+       if (Sink->Pending || waitFor) {
+              long entered = syscall(__NR_io_uring_enter, Sink->UringFd, Sink->Pending, waitFor, IORING_ENTER_GETEVENTS, nullptr, 0);
+              //* A short submit leaves the rest in the SQ ring: resubmit it, or leave it to the next call if none went in.
+              while (entered > 0 && (unsigned int)entered < Sink->Pending) {
+                     Sink->Pending -= entered;
+                     entered = syscall(__NR_io_uring_enter, Sink->UringFd, Sink->Pending, 0, 0, nullptr, 0);
+              }
+              if (entered < 0) {
+                     std::cerr << "io_uring_enter failed: " << strerror(errno) << std::endl;
+                     return -1;
+              }
+              Sink->Pending -= entered;
+       }
+
+       if (!ReapSinkWrites(Sink, Ring)) {
+              return -1;
+       }
+
+       return submitted;
+}
+
+//* Waits until every submitted write has completed.
+bool
+FlushRingSink(
+       RingSink* Sink,
+       RingBuffer* Ring
+) {
+       while (Sink->UringFd >= 0 && Sink->WritesHead != Sink->WritesTail) {
+              if (SinkMessageBuffer(Sink, Ring) < 0) {
+                     return false;
+              }
+       }
+       return true;
+}
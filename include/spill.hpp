@@ -0,0 +1,172 @@
+#include "common.hpp"
+
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+
+#define SPILL_LIMIT         268435456
+#define SPILL_ACTIVE        (1ULL << 63)
+
+
+//* Memory-mapped overflow log used while the ring is saturated. Frames use the ring framing
+//* (MessageSizeT header, padded to CACHE_LINE) and are appended linearly; the log is reset once drained.
+struct SpillLog {
+       //* SPILL_ACTIVE | bytes reserved in the current generation.
+       Atomic<unsigned long long> State[INT_ALIGNED / 2];
+       Atomic<unsigned long long> PeakBytes[INT_ALIGNED / 2];
+       Atomic<unsigned long long> Generations[INT_ALIGNED / 2];
+       unsigned long long ReadOffset[INT_ALIGNED / 2];
+       size_t Limit;
+       char* Data;
+       int Fd;
+};
+
+bool
+OpenSpillLog(
+       SpillLog* Spill,
+       const char* Path,
+       size_t Limit
+) {
+       memset((void*)Spill, 0, sizeof(SpillLog));
+       Spill->Limit = Limit;
+
+       Spill->Fd = open(Path, O_CREAT | O_TRUNC | O_RDWR, 0600);
+       if (Spill->Fd < 0 || ftruncate(Spill->Fd, Limit) != 0) {
+              std::cerr << "Error opening spill log " << Path << ": " << strerror(errno) << std::endl;
+              return false;
+       }
+
+       void* address = mmap(nullptr, Limit, PROT_READ | PROT_WRITE, MAP_SHARED, Spill->Fd, 0);
+       if (address == MAP_FAILED) {
+              std::cerr << "Error mapping spill log " << Path << ": " << strerror(errno) << std::endl;
+              close(Spill->Fd);
+              return false;
+       }
+       Spill->Data = (char*)address;
+
+       return true;
+}
+
+void
+CloseSpillLog(
+       SpillLog* Spill,
+       const char* Path
+) {
+       munmap(Spill->Data, Spill->Limit);
+       close(Spill->Fd);
+       unlink(Path);
+}
+
+bool
+SpillActive(
+       SpillLog* Spill
+) {
+       return Spill->State[0].load(std::memory_order_acquire) & SPILL_ACTIVE;
+}
+
+//* Reserves space at the end of the log and publishes the frame by storing its header last.
+//* Returns false when the log is at its limit.
+bool
+SpillAppend(
+       SpillLog* Spill,
+       const BufferT CopyFrom,
+       MessageSizeT MessageSize
+) {
+       MessageSizeT messageBytes = sizeof(MessageSizeT) + MessageSize;
+       while (messageBytes % CACHE_LINE != 0) {
+              messageBytes++;
+       }
+
+       unsigned long long state;
+       unsigned long long offset;
+
+       do {
+              state = Spill->State[0].load(std::memory_order_relaxed);
+              offset = state & ~SPILL_ACTIVE;
+
+              if (offset + messageBytes > Spill->Limit) {
+                     return false;
+              }
+       } while (Spill->State[0].compare_exchange_weak(
+              state, SPILL_ACTIVE | (offset + messageBytes), std::memory_order_acq_rel, std::memory_order_relaxed) == false);
+
+       if (offset == 0) {
+              Spill->Generations[0].fetch_add(1, std::memory_order_relaxed);
+       }
+       unsigned long long peak = Spill->PeakBytes[0].load(std::memory_order_relaxed);
+       while (offset + messageBytes > peak && !Spill->PeakBytes[0].compare_exchange_weak(peak, offset + messageBytes)) {}
+
+       //* The consumer reads the log only after draining the ring, so at least the log in front of this frame is backlog.
+       char* messageAddress = &Spill->Data[offset];
+       CopyToRing(messageAddress + sizeof(MessageSizeT), CopyFrom, MessageSize, offset);
+       ((Atomic<MessageSizeT>*)messageAddress)->store(messageBytes, std::memory_order_release);
+
+       return true;
+}
+
+//* While the log is active every insert goes to it, so a producer's messages never overtake each other:
+//* anything it put in the ring was inserted before its first spilled message.
+bool
+SpillInsertToMessageBuffer(
+       InsertFunctionT Insert,
+       RingBuffer* Ring,
+       SpillLog* Spill,
+       const BufferT CopyFrom,
+       MessageSizeT MessageSize
+) {
+       if (!SpillActive(Spill) && Insert(Ring, CopyFrom, MessageSize)) {
+              return true;
+       }
+
+       return SpillAppend(Spill, CopyFrom, MessageSize);
+}
+
+//* The consumer may only read the log once the ring holds neither data nor reservations.
+bool
+RingDrained(
+       RingBuffer* Ring
+) {
+       return Ring->ForwardTail[0].load(mem_barrier) == Ring->Head[0].load(std::memory_order_relaxed);
+}
+
+//* Visits up to MaxBatch spilled frames in order, zeroing them for the next generation.
+//* Resets the log once the reader has caught up with every reservation. Returns the frames consumed.
+template <class VisitorT>
+size_t
+ConsumeSpill(
+       SpillLog* Spill,
+       VisitorT Visitor,
+       size_t MaxBatch
+) {
+       unsigned long long state = Spill->State[0].load(std::memory_order_acquire);
+       if (!(state & SPILL_ACTIVE)) {
+              return 0;
+       }
+
+       unsigned long long readOffset = Spill->ReadOffset[0];
+       unsigned long long reserved = state & ~SPILL_ACTIVE;
+       size_t consumed = 0;
+
+       while (readOffset < reserved && consumed < MaxBatch) {
+              char* frame = &Spill->Data[readOffset];
+              MessageSizeT frameBytes = ((Atomic<MessageSizeT>*)frame)->load(std::memory_order_acquire);
+              if (frameBytes == 0) {
+                     break;
+              }
+
+              Visitor((BufferT)(frame + sizeof(MessageSizeT)), frameBytes - sizeof(MessageSizeT));
+              memset(frame, 0, frameBytes);
+              readOffset += frameBytes;
+              consumed++;
+       }
+       Spill->ReadOffset[0] = readOffset;
+
+       //* Fails if a producer reserved more in the meantime; the next call picks those frames up.
+       unsigned long long caughtUp = SPILL_ACTIVE | readOffset;
+       if (readOffset == reserved && Spill->State[0].compare_exchange_strong(caughtUp, 0, std::memory_order_acq_rel)) {
+              Spill->ReadOffset[0] = 0;
+       }
+
+       return consumed;
+}
@@ -0,0 +1,87 @@
+#include "common.hpp"
+#include "optimized.hpp"
+
+#define SIZE_MASK (RING_SIZE - 1)
+
+
+//* Single producer: no CAS on ForwardTail/SafeTail and no waiting for earlier commits.
+//* Head is only re-read when the cached copy says the ring is full or the frame would be streamed.
+bool
+SpscInsertToMessageBuffer(
+       RingBuffer* Ring,
+       const BufferT CopyFrom,
+       MessageSizeT MessageSize
+) {
+       MessageSizeT messageBytes = sizeof(MessageSizeT) + MessageSize;
+       while (messageBytes % CACHE_LINE != 0) {
+              messageBytes++;
+       }
+
+       int forwardTail = Ring->ForwardTail[0].load(std::memory_order_relaxed);
+       int head = Ring->CachedHead[0];
+       RingSizeT distance = (forwardTail < head)? forwardTail + RING_SIZE - head : forwardTail - head;
+
+       //* A frame the copy may stream also re-reads Head, as the cached one overstates how far behind the consumer is.
+       if (distance >= FORWARD_DEGREE || messageBytes > RING_SIZE - distance
+              || (MessageSize >= STREAM_MIN && distance + MessageSize >= StreamBacklog())) {
+              head = Ring->Head[0].load(ORDER_HEAD_LOAD);
+              Ring->CachedHead[0] = head;
+              distance = (forwardTail < head)? forwardTail + RING_SIZE - head : forwardTail - head;
+
+              if (distance >= FORWARD_DEGREE) {
+                     TELEMETRY_COUNT(Rejects, 1);
+                     return false;
+              }
+
+              if (messageBytes > RING_SIZE - distance) {
+                     TELEMETRY_COUNT(Rejects, 1);
+                     return false;
+              }
+       }
+
+       if (forwardTail + messageBytes <= RING_SIZE) {
+              char* messageAddress = &Ring->Buffer[forwardTail];
+
+              *((MessageSizeT*)messageAddress) = messageBytes;
+
+              CopyToRing(messageAddress + sizeof(MessageSizeT), CopyFrom, MessageSize, distance);
+       }
+       else {
+              RingSizeT remainingBytes = RING_SIZE - forwardTail - sizeof(MessageSizeT);
+              char* messageAddress1 = &Ring->Buffer[forwardTail];
+              *((MessageSizeT*)messageAddress1) = messageBytes;
+
+              if (MessageSize <= remainingBytes) {
+                     CopyToRing(messageAddress1 + sizeof(MessageSizeT), CopyFrom, MessageSize, distance);
+              } else {
+                     char* messageAddress2 = &Ring->Buffer[0];
+                     if (remainingBytes) {
+                            CopyToRing(messageAddress1 + sizeof(MessageSizeT), CopyFrom, remainingBytes, distance);
+                     }
+                     CopyToRing(messageAddress2, (const char*)CopyFrom + remainingBytes, MessageSize - remainingBytes, distance);
+              }
+       }
+
+       int nextTail = (forwardTail + messageBytes) & SIZE_MASK;
+       Ring->ForwardTail[0].store(nextTail, std::memory_order_relaxed);
+       Ring->Tail.store(nextTail, ORDER_COMMIT);
+
+       TELEMETRY_COUNT(Inserts, 1);
+       return true;
+}
+
+//* Records how many producers will share the ring and picks the insert path for it.
+InsertFunctionT
+RegisterProducers(
+       RingBuffer* Ring,
+       int NumProducers
+) {
+       Ring->NumProducers[0] = NumProducers;
+       Ring->CachedHead[0] = Ring->Head[0].load(std::memory_order_relaxed);
+       Ring->Tail.store(Ring->ForwardTail[0].load(mem_barrier), std::memory_order_relaxed);
+
+       if (NumProducers == 1) {
+              return &SpscInsertToMessageBuffer;
+       }
+       return &OptimizedInsertToMessageBuffer;
+}
@@ -1,9 +1,14 @@
 #include "common.hpp"
 
+#include <type_traits>
 
 #define mem_relaxed std::memory_order_relaxed
 #define SIZE_MASK (RING_SIZE - 1)
 
+//* The commit wait spins on Tail. As a plain int, -O2 builds (sink, lanes, coro) hoist the load out of the loop
+//* and commit out of order, so keep it atomic.
+static_assert(std::is_same<decltype(RingBuffer::Tail), Atomic<int>>::value, "the commit wait needs an atomic Tail");
+
 
 bool
 TailInsertToMessageBuffer(
@@ -21,8 +26,8 @@ TailInsertToMessageBuffer(
        RingSizeT distance = 0;
 
        do {
-              forwardTail = Ring->ForwardTail[0].load(mem_barrier);
-              head = Ring->Head[0];
+              forwardTail = Ring->ForwardTail[0].load(ORDER_RESERVE);
+              head = Ring->Head[0].load(ORDER_HEAD_LOAD);
               
               if (forwardTail < head) {
                      distance = forwardTail + RING_SIZE - head;
@@ -32,21 +37,24 @@ TailInsertToMessageBuffer(
               }
 
               if (distance >= FORWARD_DEGREE) {
+                     TELEMETRY_COUNT(Rejects, 1);
                      return false;
               }
 
               if (messageBytes > RING_SIZE - distance) {
+                     TELEMETRY_COUNT(Rejects, 1);
                      return false;
               }
        } while (Ring->ForwardTail[0].compare_exchange_weak(
-              forwardTail, (forwardTail + messageBytes) % RING_SIZE, mem_barrier, mem_barrier) == false);
+              forwardTail, (forwardTail + messageBytes) % RING_SIZE, ORDER_RESERVE, std::memory_order_relaxed) == false);
+       TRACE_EVENT(TRACE_RESERVE, forwardTail, messageBytes);
        
        if (forwardTail + messageBytes <= RING_SIZE) {
               char* messageAddress = &Ring->Buffer[forwardTail];
  
               *((MessageSizeT*)messageAddress) = messageBytes;
  
-              memcpy(messageAddress + sizeof(MessageSizeT), CopyFrom, MessageSize);
+              CopyToRing(messageAddress + sizeof(MessageSizeT), CopyFrom, MessageSize, distance);
        }
        else {
               RingSizeT remainingBytes = RING_SIZE - forwardTail - sizeof(MessageSizeT);
@@ -54,23 +62,23 @@ TailInsertToMessageBuffer(
               *((MessageSizeT*)messageAddress1) = messageBytes;
 
               if (MessageSize <= remainingBytes) {
-                     memcpy(messageAddress1 + sizeof(MessageSizeT), CopyFrom, MessageSize);
+                     CopyToRing(messageAddress1 + sizeof(MessageSizeT), CopyFrom, MessageSize, distance);
               } else {
                      char* messageAddress2 = &Ring->Buffer[0];
                      if (remainingBytes) {
-                            memcpy(messageAddress1 + sizeof(MessageSizeT), CopyFrom, remainingBytes);
+                            CopyToRing(messageAddress1 + sizeof(MessageSizeT), CopyFrom, remainingBytes, distance);
                      }
-                     memcpy(messageAddress2, (const char*)CopyFrom + remainingBytes, MessageSize - remainingBytes);
+                     CopyToRing(messageAddress2, (const char*)CopyFrom + remainingBytes, MessageSize - remainingBytes, distance);
               }
        }
 
-       while (Ring->Tail != forwardTail) {}
+       TRACE_EVENT(TRACE_WAIT, forwardTail, 0);
+       while (Ring->Tail.load(ORDER_COMMIT_WAIT) != forwardTail) {}
 
-#ifdef ARM
-       std::atomic_thread_fence(std::memory_order_release);
-#endif
-       Ring->Tail = (forwardTail + messageBytes) & SIZE_MASK;
+       Ring->Tail.store((forwardTail + messageBytes) & SIZE_MASK, ORDER_COMMIT);
+       TRACE_EVENT(TRACE_COMMIT, forwardTail, messageBytes);
 
+       TELEMETRY_COUNT(Inserts, 1);
        return true;
 }
  
\ No newline at end of file
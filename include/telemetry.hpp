@@ -0,0 +1,90 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+
+//* Opt-in insert and drain counters (-DTELEMETRY), read by the sampler in sampler.hpp. Each thread counts into a
+//* cache-line slot of its own with plain relaxed stores, so counting adds no shared writes to an insert.
+//* Without -DTELEMETRY the TELEMETRY_COUNT sites compile to nothing.
+
+//* Threads beyond this share the last slot, which then counts with atomic adds.
+#define TELEMETRY_SLOTS     128
+
+
+struct alignas(CACHE_LINE) TelemetrySlotT {
+       std::atomic<unsigned long long> Inserts;
+       std::atomic<unsigned long long> Rejects;
+       std::atomic<unsigned long long> DrainedBytes;
+};
+
+struct TelemetryCountersT {
+       TelemetrySlotT Slots[TELEMETRY_SLOTS];
+       std::atomic<unsigned int> NextSlot;
+       //* Bumped by a reset, so threads claim a fresh slot.
+       std::atomic<unsigned int> Generation{1};
+};
+
+TelemetryCountersT gTelemetry;
+
+//* The calling thread's slot; claimed on its first count after a reset. Shared is set for the overflow slot.
+TelemetrySlotT*
+TelemetryThreadSlot(
+       bool* Shared
+) {
+       static thread_local TelemetrySlotT* slot = nullptr;
+       static thread_local unsigned int generation = 0;
+
+       //* Resets happen while no counting thread runs, so a relaxed load sees the current generation.
+       unsigned int current = gTelemetry.Generation.load(std::memory_order_relaxed);
+       if (generation != current) {
+              slot = &gTelemetry.Slots[std::min(gTelemetry.NextSlot.fetch_add(1, std::memory_order_relaxed), TELEMETRY_SLOTS - 1u)];
+              generation = current;
+       }
+       *Shared = slot == &gTelemetry.Slots[TELEMETRY_SLOTS - 1];
+       return slot;
+}
+
+void
+TelemetryAdd(
+       std::atomic<unsigned long long> TelemetrySlotT::* Counter,
+       unsigned long long Amount
+) {
+       bool shared;
+       std::atomic<unsigned long long>& counter = TelemetryThreadSlot(&shared)->*Counter;
+       if (shared) {
+              counter.fetch_add(Amount, std::memory_order_relaxed);
+       }
+       else {
+              counter.store(counter.load(std::memory_order_relaxed) + Amount, std::memory_order_relaxed);
+       }
+}
+
+//* Sums a counter over all slots; relaxed reads only.
+unsigned long long
+TelemetryTotal(
+       std::atomic<unsigned long long> TelemetrySlotT::* Counter
+) {
+       unsigned long long total = 0;
+       for (unsigned int slot = 0; slot < TELEMETRY_SLOTS; slot++) {
+              total += (gTelemetry.Slots[slot].*Counter).load(std::memory_order_relaxed);
+       }
+       return total;
+}
+
+//* Zeroes the counters; call while no counting thread is running.
+void
+TelemetryReset() {
+       for (unsigned int slot = 0; slot < TELEMETRY_SLOTS; slot++) {
+              gTelemetry.Slots[slot].Inserts.store(0, std::memory_order_relaxed);
+              gTelemetry.Slots[slot].Rejects.store(0, std::memory_order_relaxed);
+              gTelemetry.Slots[slot].DrainedBytes.store(0, std::memory_order_relaxed);
+       }
+       gTelemetry.NextSlot.store(0, std::memory_order_relaxed);
+       gTelemetry.Generation.fetch_add(1, std::memory_order_relaxed);
+}
+
+#ifdef TELEMETRY
+       #define TELEMETRY_COUNT(Counter, Amount) TelemetryAdd(&TelemetrySlotT::Counter, Amount)
+#else
+       #define TELEMETRY_COUNT(Counter, Amount) do {} while (0)
+#endif
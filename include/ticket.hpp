@@ -0,0 +1,104 @@
+#include "common.hpp"
+
+#define SIZE_MASK (RING_SIZE - 1)
+//* Spins on a turn or a commit before yielding the core to whoever holds it.
+#define TICKET_SPIN_LIMIT   1024
+
+
+//* Whether a frame of MessageBytes does not fit behind ForwardTail; stores the consumer's distance in Distance.
+bool
+TicketRingFull(
+       RingBuffer* Ring,
+       int ForwardTail,
+       MessageSizeT MessageBytes,
+       RingSizeT* Distance
+) {
+       int head = Ring->Head[0].load(ORDER_HEAD_LOAD);
+       RingSizeT distance = 0;
+
+       if (ForwardTail < head) {
+              distance = ForwardTail + RING_SIZE - head;
+       }
+       else {
+              distance = ForwardTail - head;
+       }
+
+       *Distance = distance;
+       return distance >= FORWARD_DEGREE || MessageBytes > RING_SIZE - distance;
+}
+
+//* Reservations are handed out in ticket order instead of to whoever wins the CAS on ForwardTail,
+//* so a producer waits behind at most the producers that asked before it. Commits follow the same order.
+//* A producer that finds the ring full passes its turn on and takes a new ticket when it retries.
+bool
+TicketInsertToMessageBuffer(
+       RingBuffer* Ring,
+       const BufferT CopyFrom,
+       MessageSizeT MessageSize
+) {
+       MessageSizeT messageBytes = sizeof(MessageSizeT) + MessageSize;
+       while (messageBytes % CACHE_LINE != 0) {
+              messageBytes++;
+       }
+       RingSizeT distance = 0;
+
+       //* Do not queue for a turn that can only fail.
+       if (TicketRingFull(Ring, Ring->ForwardTail[0].load(std::memory_order_relaxed), messageBytes, &distance)) {
+              TELEMETRY_COUNT(Rejects, 1);
+              return false;
+       }
+
+       unsigned int ticket = Ring->NextTicket[0].fetch_add(1, std::memory_order_relaxed);
+       unsigned int spins = 0;
+       while (Ring->NowServing[0].load(std::memory_order_acquire) != ticket) {
+              if (++spins > TICKET_SPIN_LIMIT) {
+                     std::this_thread::yield();
+              }
+       }
+
+       //* Only the turn holder moves ForwardTail, so no CAS is needed.
+       int forwardTail = Ring->ForwardTail[0].load(std::memory_order_relaxed);
+       if (TicketRingFull(Ring, forwardTail, messageBytes, &distance)) {
+              Ring->NowServing[0].store(ticket + 1, std::memory_order_release);
+              TELEMETRY_COUNT(Rejects, 1);
+              return false;
+       }
+
+       Ring->ForwardTail[0].store((forwardTail + messageBytes) % RING_SIZE, mem_barrier);
+       Ring->NowServing[0].store(ticket + 1, std::memory_order_release);
+
+       if (forwardTail + messageBytes <= RING_SIZE) {
+              char* messageAddress = &Ring->Buffer[forwardTail];
+
+              *((MessageSizeT*)messageAddress) = messageBytes;
+
+              CopyToRing(messageAddress + sizeof(MessageSizeT), CopyFrom, MessageSize, distance);
+       }
+       else {
+              RingSizeT remainingBytes = RING_SIZE - forwardTail - sizeof(MessageSizeT);
+              char* messageAddress1 = &Ring->Buffer[forwardTail];
+              *((MessageSizeT*)messageAddress1) = messageBytes;
+
+              if (MessageSize <= remainingBytes) {
+                     CopyToRing(messageAddress1 + sizeof(MessageSizeT), CopyFrom, MessageSize, distance);
+              } else {
+                     char* messageAddress2 = &Ring->Buffer[0];
+                     if (remainingBytes) {
+                            CopyToRing(messageAddress1 + sizeof(MessageSizeT), CopyFrom, remainingBytes, distance);
+                     }
+                     CopyToRing(messageAddress2, (const char*)CopyFrom + remainingBytes, MessageSize - remainingBytes, distance);
+              }
+       }
+
+       spins = 0;
+       while (Ring->Tail.load(ORDER_COMMIT_WAIT) != forwardTail) {
+              if (++spins > TICKET_SPIN_LIMIT) {
+                     std::this_thread::yield();
+              }
+       }
+
+       Ring->Tail.store((forwardTail + messageBytes) & SIZE_MASK, ORDER_COMMIT);
+
+       TELEMETRY_COUNT(Inserts, 1);
+       return true;
+}
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+//* Opt-in event tracer (-DTRACE). Every thread appends fixed-size TSC-stamped events to a ring of its own,
+//* so the hot path never writes shared memory; rings are only collected once their threads were joined.
+//* A ring keeps the latest TRACE_CAPACITY events, so a dump shows the steady state at the end of the run
+//* and every insert of the measured interval pays for tracing.
+//* Without -DTRACE the TRACE_EVENT sites compile to nothing. Convert a dump with src/trace2json.cpp.
+
+//* Events kept per thread (a power of two); older ones are overwritten and counted as dropped.
+#define TRACE_CAPACITY      262144
+#define TRACE_MASK          (TRACE_CAPACITY - 1)
+#define TRACE_MAGIC         "RBTRACE1"
+
+//* Producer: reserved Offset (Arg = frame bytes), copied and started waiting for Tail to reach Offset, committed.
+//* Consumer: picked up [Offset, ...), released up to Offset (Arg = frames).
+#define TRACE_RESERVE       0
+#define TRACE_WAIT          1
+#define TRACE_COMMIT        2
+#define TRACE_PICKUP        3
+#define TRACE_RELEASE       4
+
+
+struct TraceEventT {
+       unsigned long long Tsc;
+       int Offset;
+       unsigned int Kind : 8;
+       unsigned int Arg : 24;
+};
+
+struct TraceBufferT {
+       unsigned int Thread;
+       //* Events recorded so far; the latest TRACE_CAPACITY of them are in Events.
+       unsigned long long Recorded;
+       TraceEventT Events[TRACE_CAPACITY];
+};
+
+//* File layout: TraceHeaderT, then per thread a TraceThreadT followed by its Count events, oldest first.
+struct TraceHeaderT {
+       char Magic[8];
+       unsigned int Threads;
+       unsigned int Reserved;
+       double TicksPerUs;
+       unsigned long long BaseTsc;
+};
+
+struct TraceThreadT {
+       unsigned int Thread;
+       unsigned int Count;
+       unsigned long long Dropped;
+};
+
+struct TraceRegistryT {
+       std::mutex Lock;
+       std::vector<TraceBufferT*> Buffers;
+       std::atomic<unsigned int> Generation{1};
+       unsigned long long BaseTsc;
+       std::chrono::steady_clock::time_point BaseTime;
+};
+
+TraceRegistryT gTrace;
+
+unsigned long long
+TraceClock() {
+#if defined(__x86_64__) || defined(__i386__)
+       return __rdtsc();
+#elif defined(__aarch64__)
+       unsigned long long ticks;
+       asm volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+       return ticks;
+#else
+       return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+//* First event of a thread in this trace: allocate and register its buffer (off the steady-state path).
+TraceBufferT*
+RegisterTraceBuffer() {
+       TraceBufferT* buffer = new TraceBufferT;
+       buffer->Recorded = 0;
+
+       std::lock_guard<std::mutex> guard(gTrace.Lock);
+       buffer->Thread = gTrace.Buffers.size();
+       gTrace.Buffers.push_back(buffer);
+       return buffer;
+}
+
+void
+TraceEvent(
+       unsigned int Kind,
+       int Offset,
+       unsigned int Arg
+) {
+       static thread_local TraceBufferT* buffer = nullptr;
+       static thread_local unsigned int generation = 0;
+
+       unsigned int current = gTrace.Generation.load(std::memory_order_relaxed);
+       if (generation != current) {
+              buffer = RegisterTraceBuffer();
+              generation = current;
+       }
+
+       TraceEventT* event = &buffer->Events[buffer->Recorded++ & TRACE_MASK];
+       event->Tsc = TraceClock();
+       event->Offset = Offset;
+       event->Kind = Kind;
+       event->Arg = Arg;
+}
+
+//* Frees the previous trace and starts a new one; call while no traced thread is running.
+void
+TraceReset() {
+       std::lock_guard<std::mutex> guard(gTrace.Lock);
+       for (TraceBufferT* buffer : gTrace.Buffers) {
+              delete buffer;
+       }
+       gTrace.Buffers.clear();
+       gTrace.Generation.fetch_add(1);
+       gTrace.BaseTime = std::chrono::steady_clock::now();
+       gTrace.BaseTsc = TraceClock();
+}
+
+//* Writes the trace to Path; call after the traced threads were joined. The tick rate is calibrated
+//* against steady_clock over the whole trace.
+bool
+TraceDump(
+       const char* Path
+) {
+       std::lock_guard<std::mutex> guard(gTrace.Lock);
+       double elapsedUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - gTrace.BaseTime).count();
+
+       TraceHeaderT header;
+       memcpy(header.Magic, TRACE_MAGIC, sizeof(header.Magic));
+       header.Threads = gTrace.Buffers.size();
+       header.Reserved = 0;
+       header.TicksPerUs = (elapsedUs > 0)? (TraceClock() - gTrace.BaseTsc) / elapsedUs : 1;
+       header.BaseTsc = gTrace.BaseTsc;
+
+       FILE* file = fopen(Path, "wb");
+       if (!file) {
+              std::cerr << "Error opening trace " << Path << std::endl;
+              return false;
+       }
+       fwrite(&header, sizeof(header), 1, file);
+       unsigned long long dropped = 0;
+       for (TraceBufferT* buffer : gTrace.Buffers) {
+              unsigned int count = std::min(buffer->Recorded, (unsigned long long)TRACE_CAPACITY);
+              unsigned int oldest = (buffer->Recorded - count) & TRACE_MASK;
+              TraceThreadT thread = {buffer->Thread, count, buffer->Recorded - count};
+              fwrite(&thread, sizeof(thread), 1, file);
+              fwrite(&buffer->Events[oldest], sizeof(TraceEventT), count - oldest, file);
+              fwrite(buffer->Events, sizeof(TraceEventT), oldest, file);
+              dropped += thread.Dropped;
+       }
+       fclose(file);
+
+       if (dropped) {
+              std::cout << "\tTrace:\t" << dropped << " older events overwritten (TRACE_CAPACITY per thread)" << std::endl;
+       }
+       return true;
+}
+
+#ifdef TRACE
+       #define TRACE_EVENT(Kind, Offset, Arg) TraceEvent(Kind, Offset, Arg)
+#else
+       #define TRACE_EVENT(Kind, Offset, Arg) do {} while (0)
+#endif
@@ -0,0 +1,132 @@
+#include "common.hpp"
+
+#include <type_traits>
+
+
+//* Ring of fixed-size slots for POD messages: no length header, no padding, no split copy on wrap.
+//* Indices count slots and run freely; the slot is Index & (N - 1).
+template <class T, unsigned int N>
+struct TypedRing {
+       static_assert((N & (N - 1)) == 0, "N must be a power of two");
+       static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+
+       Atomic<unsigned int> ForwardTail[INT_ALIGNED];
+       Atomic<unsigned int> Tail[INT_ALIGNED];
+       Atomic<unsigned int> Head[INT_ALIGNED];
+       T Slots[N];
+};
+
+template <class T, unsigned int N>
+TypedRing<T, N>*
+AllocateTypedBuffer(
+       BufferT BufferAddress
+) {
+       size_t ringAddress = (size_t)BufferAddress;
+       while (ringAddress % CACHE_LINE != 0) {
+              ringAddress++;
+       }
+       TypedRing<T, N>* ring = (TypedRing<T, N>*)ringAddress;
+
+       memset((void*)ring, 0, sizeof(TypedRing<T, N>));
+
+       return ring;
+}
+
+template <class T, unsigned int N>
+void
+DeallocateTypedBuffer(
+       TypedRing<T, N>* Ring
+) {
+       memset((void*)Ring, 0, sizeof(TypedRing<T, N>));
+}
+
+//* Reserves up to Count slots on ForwardTail, fills them and commits in reservation order on Tail
+//* (same scheme as the tail/optimized modes). Returns the number of messages inserted.
+template <class T, unsigned int N>
+unsigned int
+TypedInsertBulk(
+       TypedRing<T, N>* Ring,
+       const T* CopyFrom,
+       unsigned int Count
+) {
+       unsigned int forwardTail;
+       unsigned int reserved;
+       unsigned int backlog;
+
+       do {
+              forwardTail = Ring->ForwardTail[0].load(mem_barrier);
+              unsigned int head = Ring->Head[0].load(std::memory_order_acquire);
+              backlog = forwardTail - head;
+              unsigned int freeSlots = N - backlog;
+
+              if (freeSlots == 0) {
+                     return 0;
+              }
+              reserved = (Count < freeSlots)? Count : freeSlots;
+       } while (Ring->ForwardTail[0].compare_exchange_weak(
+              forwardTail, forwardTail + reserved, mem_barrier, mem_barrier) == false);
+
+       unsigned int slot = forwardTail & (N - 1);
+       unsigned int firstSlots = (reserved < N - slot)? reserved : N - slot;
+       CopyToRing(&Ring->Slots[slot], CopyFrom, firstSlots * sizeof(T), backlog * sizeof(T));
+       if (firstSlots < reserved) {
+              CopyToRing(&Ring->Slots[0], CopyFrom + firstSlots, (reserved - firstSlots) * sizeof(T), backlog * sizeof(T));
+       }
+
+       while (Ring->Tail[0].load(std::memory_order_acquire) != forwardTail) {
+              if (gNumProducers >= TOTAL_CORES/4) {
+                     std::this_thread::yield();
+              }
+       }
+
+       Ring->Tail[0].store(forwardTail + reserved, std::memory_order_release);
+
+       return reserved;
+}
+
+template <class T, unsigned int N>
+bool
+TypedInsert(
+       TypedRing<T, N>* Ring,
+       const T& Message
+) {
+       return TypedInsertBulk(Ring, &Message, 1) == 1;
+}
+
+//* Single consumer: copies up to MaxCount committed messages out and frees their slots.
+template <class T, unsigned int N>
+unsigned int
+TypedFetchBulk(
+       TypedRing<T, N>* Ring,
+       T* CopyTo,
+       unsigned int MaxCount
+) {
+       unsigned int tail = Ring->Tail[0].load(std::memory_order_acquire);
+       unsigned int head = Ring->Head[0].load(std::memory_order_relaxed);
+       unsigned int available = tail - head;
+
+       if (available == 0) {
+              return 0;
+       }
+       unsigned int count = (available < MaxCount)? available : MaxCount;
+
+       unsigned int slot = head & (N - 1);
+       unsigned int firstSlots = (count < N - slot)? count : N - slot;
+       memcpy(CopyTo, &Ring->Slots[slot], firstSlots * sizeof(T));
+       if (firstSlots < count) {
+              memcpy(CopyTo + firstSlots, &Ring->Slots[0], (count - firstSlots) * sizeof(T));
+       }
+
+       Ring->Head[0].store(head + count, std::memory_order_release);
+
+       return count;
+}
+
+template <class T, unsigned int N>
+bool
+TypedFetch(
+       TypedRing<T, N>* Ring,
+       T* CopyTo
+) {
+       return TypedFetchBulk(Ring, CopyTo, 1) == 1;
+}
@@ -0,0 +1,411 @@
+#!/usr/bin/env python3
+"""Statistics over the benchmark CSVs in data/.
+
+    stats.py summarize [CSV ...]            median, stddev, 95% CI, outliers and rerun instability
+    stats.py save [--baseline DIR]          store the current results as the baseline
+    stats.py compare [--baseline DIR] [CSV ...]
+                                            flag significant changes against the baseline
+    stats.py overhead BASE VARIANT [--budget FRACTION] [--report-only]
+                                            throughput cost of a variant build (tracing, telemetry, integrity)
+    stats.py plot [--out DIR]               regenerate data/figures (needs matplotlib)
+    stats.py selfcheck                      run the script's own checks on generated CSVs
+
+Only CSVs in the schema of src/main.cpp are read; the other harnesses (shm, lanes, sink, coro) write
+their own. Rows are grouped by (mode, num_producers, busy_threads). Only the standard library is needed, so
+the suite runs on the benchmark machines as is.
+"""
+
+import argparse
+import contextlib
+import csv
+import glob
+import math
+import os
+import shutil
+import statistics
+import sys
+
+DATA_DIR = "data"
+BASELINE_DIR = os.path.join(DATA_DIR, "baseline")
+FIGURES_DIR = os.path.join(DATA_DIR, "figures")
+
+# Modified z-score (median/MAD) above which a sample counts as an outlier (Iglewicz and Hoaglin).
+OUTLIER_Z = 3.5
+# Fewer samples than this give no usable spread estimate for outliers.
+OUTLIER_MIN_SAMPLES = 5
+# Relative spread between the medians of separate sweeps in one file that counts as unstable.
+RERUN_SPREAD = 0.10
+
+# Two-sided 97.5% quantiles of Student's t for 1..30 degrees of freedom.
+T_975 = [12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+         2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+         2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042]
+
+# Leading columns of the CSVs src/main.cpp writes; some modes append more.
+MAIN_COLUMNS = ["mode", "num_producers", "throughput_mps"]
+
+# Figures in data/figures and the modes each one compares.
+FIGURES = {
+    "solutioins": ["lock", "spin", "notify", "yield", "free"],
+    "ablations": ["tail", "optimized", "ticket", "auto"],
+    "optimized": ["single", "lock", "optimized"],
+}
+
+
+def t_quantile(df):
+    if df < 1:
+        return float("nan")
+    return T_975[df - 1] if df <= len(T_975) else 1.96
+
+
+def incomplete_beta(a, b, x):
+    """Regularized incomplete beta I_x(a, b) by Lentz's continued fraction."""
+    if x <= 0:
+        return 0.0
+    if x >= 1:
+        return 1.0
+    if x > (a + 1) / (a + b + 2):
+        return 1.0 - incomplete_beta(b, a, 1.0 - x)
+
+    front = math.exp(math.lgamma(a + b) - math.lgamma(a) - math.lgamma(b)
+                     + a * math.log(x) + b * math.log(1.0 - x)) / a
+    tiny = 1e-300
+    c, d = 1.0, 1.0 - (a + b) * x / (a + 1)
+    d = 1.0 / (d if abs(d) > tiny else tiny)
+    result = d
+    for m in range(1, 200):
+        for numerator in (m * (b - m) * x / ((a + 2 * m - 1) * (a + 2 * m)),
+                          -(a + m) * (a + b + m) * x / ((a + 2 * m) * (a + 2 * m + 1))):
+            d = 1.0 + numerator * d
+            d = 1.0 / (d if abs(d) > tiny else tiny)
+            c = 1.0 + numerator / c
+            c = c if abs(c) > tiny else tiny
+            result *= c * d
+        if abs(c * d - 1.0) < 1e-12:
+            break
+    return front * result
+
+
+def welch(a, b):
+    """Two-sided p-value of Welch's t-test, None if either side has fewer than two samples."""
+    if len(a) < 2 or len(b) < 2:
+        return None
+    va, vb = statistics.variance(a) / len(a), statistics.variance(b) / len(b)
+    if va + vb == 0:
+        return 0.0 if statistics.mean(a) != statistics.mean(b) else 1.0
+    t = (statistics.mean(a) - statistics.mean(b)) / math.sqrt(va + vb)
+    df = (va + vb) ** 2 / (va ** 2 / (len(a) - 1) + vb ** 2 / (len(b) - 1))
+    return incomplete_beta(df / 2, 0.5, df / (df + t * t))
+
+
+def outliers(samples):
+    """Indices of samples whose modified z-score exceeds OUTLIER_Z."""
+    if len(samples) < OUTLIER_MIN_SAMPLES:
+        return []
+    median = statistics.median(samples)
+    mad = statistics.median(abs(x - median) for x in samples)
+    if mad == 0:
+        return []
+    return [i for i, x in enumerate(samples) if 0.6745 * abs(x - median) / mad > OUTLIER_Z]
+
+
+class Group:
+    """Samples of one (mode, num_producers, busy_threads), with the sweep of the file each came from."""
+
+    def __init__(self, key):
+        self.key = key
+        self.samples = []
+        self.sweeps = []
+
+    def summary(self):
+        n = len(self.samples)
+        mean = statistics.mean(self.samples)
+        stddev = statistics.stdev(self.samples) if n > 1 else 0.0
+        half = t_quantile(n - 1) * stddev / math.sqrt(n) if n > 1 else float("nan")
+        return {
+            "n": n,
+            "median": statistics.median(self.samples),
+            "mean": mean,
+            "stddev": stddev,
+            "cv": stddev / mean if mean else 0.0,
+            "ci_low": mean - half,
+            "ci_high": mean + half,
+            "outliers": [self.samples[i] for i in outliers(self.samples)],
+            "rerun_spread": self.rerun_spread(),
+        }
+
+    def rerun_spread(self):
+        """Relative spread of the per-sweep medians, 0 if the file holds a single sweep."""
+        medians = []
+        for sweep in sorted(set(self.sweeps)):
+            values = [x for x, s in zip(self.samples, self.sweeps) if s == sweep]
+            medians.append(statistics.median(values))
+        if len(medians) < 2:
+            return 0.0
+        return (max(medians) - min(medians)) / statistics.median(medians)
+
+
+def default_csvs(directory=DATA_DIR):
+    paths = sorted(glob.glob(os.path.join(directory, "*.csv")))
+    return [p for p in paths if not p.endswith("-producers.csv")]
+
+
+def load(paths):
+    """Groups by key, and the number of sweeps found per file.
+
+    Runs write producer counts in increasing order, so a count lower than its predecessor starts
+    another sweep: a rerun appended to, or interleaved with, an earlier partial one.
+    """
+    groups = {}
+    sweeps = {}
+    for path in paths:
+        with open(path, newline="") as f:
+            reader = csv.DictReader(f)
+            # shm.csv and lanes.csv also have num_producers and throughput_mps, but no mode, and lanes.csv
+            # repeats one run's throughput on every lane row.
+            if (reader.fieldnames or [])[:len(MAIN_COLUMNS)] != MAIN_COLUMNS:
+                continue
+            sweep, previous = 0, 0
+            for row in reader:
+                producers = int(row["num_producers"])
+                if producers < previous:
+                    sweep += 1
+                previous = producers
+                key = (row["mode"], producers, int(row.get("busy_threads") or 0))
+                group = groups.setdefault(key, Group(key))
+                group.samples.append(float(row["throughput_mps"]))
+                group.sweeps.append((path, sweep))
+            sweeps[path] = sweep + 1
+    return groups, sweeps
+
+
+def label(key):
+    mode, producers, busy = key
+    return f"{mode:<10} {producers:>4}" + (f" busy {busy}" if busy else "")
+
+
+def summarize(args):
+    groups, sweeps = load(args.csv or default_csvs())
+    if not groups:
+        sys.exit("No results found")
+
+    print(f"{'mode':<10} {'prod':>4} {'n':>3} {'median MPS':>12} {'stddev':>11} {'cv':>6}  {'95% CI of mean':>25}  notes")
+    for key in sorted(groups):
+        s = groups[key].summary()
+        notes = []
+        if s["outliers"]:
+            notes.append("outliers " + ", ".join(f"{x:.0f}" for x in s["outliers"]))
+        if s["rerun_spread"] > RERUN_SPREAD:
+            notes.append(f"reruns disagree by {s['rerun_spread']:.0%}")
+        if s["n"] < 3:
+            notes.append("too few samples")
+        ci = f"[{s['ci_low']:.0f}, {s['ci_high']:.0f}]" if s["n"] > 1 else "-"
+        print(f"{label(key)} {s['n']:>3} {s['median']:>12.0f} {s['stddev']:>11.0f} {s['cv']:>6.1%}  {ci:>25}  {'; '.join(notes)}")
+
+    for path, count in sorted(sweeps.items()):
+        if count > 1:
+            print(f"\n{path}: {count} sweeps in one file (reruns appended to or interleaved with partial runs)")
+
+
+def save(args):
+    os.makedirs(args.baseline, exist_ok=True)
+    for path in default_csvs():
+        shutil.copy(path, args.baseline)
+        print(f"{path} -> {args.baseline}")
+
+
+def compare(args):
+    base, _ = load(default_csvs(args.baseline))
+    if not base:
+        sys.exit(f"No baseline in {args.baseline}, store one with: stats.py save")
+    current, _ = load(args.csv or default_csvs())
+
+    regressions = 0
+    print(f"{'mode':<10} {'prod':>4} {'baseline':>12} {'current':>12} {'change':>8} {'p':>7}  verdict")
+    for key in sorted(set(base) & set(current)):
+        a, b = base[key].samples, current[key].samples
+        change = (statistics.median(b) - statistics.median(a)) / statistics.median(a)
+        p = welch(a, b)
+        if p is None:
+            verdict = "too few samples"
+        elif p < args.alpha and change <= -args.threshold:
+            verdict = "REGRESSION"
+            regressions += 1
+        elif p < args.alpha and change >= args.threshold:
+            verdict = "improvement"
+        else:
+            verdict = "-"
+        p_text = f"{p:.3f}" if p is not None else "-"
+        print(f"{label(key)} {statistics.median(a):>12.0f} {statistics.median(b):>12.0f} {change:>+8.1%} {p_text:>7}  {verdict}")
+
+    print(f"\n{regressions} significant regression(s) beyond {args.threshold:.0%} at p < {args.alpha}")
+    return 1 if regressions else 0
+
+
+def overhead(args):
+    """Matches the two files by producer count, whatever their mode column says. The cost is the geometric mean
+    of the per-count throughput ratios, so every producer count weighs the same. It passes only if the upper
+    end of its 95% confidence interval is within budget: an overhead too noisy to bound fails."""
+    base, _ = load([args.base])
+    variant, _ = load([args.variant])
+    base = {key[1:]: group for key, group in base.items()}
+    variant = {key[1:]: group for key, group in variant.items()}
+    keys = sorted(set(base) & set(variant))
+    if not keys:
+        sys.exit(f"No producer counts in common between {args.base} and {args.variant}")
+
+    # Per count: difference of the mean log throughputs and its variance (Welch).
+    differences, variances, df_terms = [], [], []
+    print(f"{'prod':>4} {'base':>12} {'variant':>12} {'overhead':>9} {'p':>7}")
+    for key in keys:
+        a, b = base[key].samples, variant[key].samples
+        log_a, log_b = [math.log(x) for x in a if x > 0], [math.log(x) for x in b if x > 0]
+        differences.append(statistics.mean(log_b) - statistics.mean(log_a))
+        if len(log_a) > 1 and len(log_b) > 1:
+            va, vb = statistics.variance(log_a) / len(log_a), statistics.variance(log_b) / len(log_b)
+            variances.append(va + vb)
+            df_terms.append(va ** 2 / (len(log_a) - 1) + vb ** 2 / (len(log_b) - 1))
+        p = welch(a, b)
+        p_text = f"{p:.3f}" if p is not None else "-"
+        busy = f" busy {key[1]}" if key[1] else ""
+        print(f"{key[0]:>4} {statistics.median(a):>12.0f} {statistics.median(b):>12.0f} "
+              f"{1 - math.exp(differences[-1]):>+9.2%} {p_text:>7}{busy}")
+
+    difference = statistics.mean(differences)
+    cost = 1 - math.exp(difference)
+    upper = None
+    if len(variances) == len(keys):
+        stderr = math.sqrt(sum(variances)) / len(keys)
+        df = sum(variances) ** 2 / sum(df_terms) if sum(df_terms) else float("inf")
+        upper = 1 - math.exp(difference - t_quantile(int(min(df, 1e6))) * stderr)
+    bound_text = f"95% CI upper bound {upper:+.2%}" if upper is not None else "too few samples to bound"
+    if args.report_only:
+        print(f"\nOverhead: {cost:+.2%} ({bound_text})")
+        return 0
+    within = upper is not None and upper <= args.budget
+    print(f"\nOverhead: {cost:+.2%} ({bound_text}, budget {args.budget:.0%})" + ("" if within else "  NOT WITHIN BUDGET"))
+    return 0 if within else 1
+
+
+def plot(args):
+    try:
+        import matplotlib
+        matplotlib.use("Agg")
+        import matplotlib.pyplot as plt
+    except ImportError:
+        sys.exit("plot needs matplotlib (pip install matplotlib)")
+
+    groups, _ = load(default_csvs())
+    os.makedirs(args.out, exist_ok=True)
+    for name, modes in FIGURES.items():
+        fig, ax = plt.subplots(figsize=(6, 4))
+        for mode in modes:
+            keys = sorted(k for k in groups if k[0] == mode and k[2] == 0)
+            if not keys:
+                continue
+            summaries = [groups[k].summary() for k in keys]
+            producers = [k[1] for k in keys]
+            medians = [s["median"] / 1e6 for s in summaries]
+            errors = [(s["ci_high"] - s["mean"]) / 1e6 if s["n"] > 1 else 0 for s in summaries]
+            ax.errorbar(producers, medians, yerr=errors, marker="o", capsize=3, label=mode)
+        ax.set_xscale("log", base=2)
+        ax.set_xlabel("Producers")
+        ax.set_ylabel("Throughput (million messages/s)")
+        ax.legend()
+        ax.grid(alpha=0.3)
+        fig.tight_layout()
+        path = os.path.join(args.out, name + ".pdf")
+        fig.savefig(path)
+        plt.close(fig)
+        print(f"Wrote {path}")
+
+
+def selfcheck(args):
+    """Loads generated CSVs of every harness from a scratch data/ directory."""
+    import tempfile
+    with tempfile.TemporaryDirectory() as directory:
+        files = {
+            "optimized.csv": [MAIN_COLUMNS + ["cpu_s_per_mmsg", "busy_threads", "jain_index"],
+                              ["optimized", 1, 100, 1, 0, 1], ["optimized", 1, 110, 1, 0, 1], ["optimized", 2, 90, 1, 0, 1]],
+            "spill.csv": [MAIN_COLUMNS + ["cpu_s_per_mmsg", "busy_threads", "jain_index", "peak_spill_bytes", "recovery_ms"],
+                          ["spill", 1, 50, 1, 0, 1, 4096, 2.5]],
+            "shm.csv": [["transport", "num_producers", "throughput_mps", "p50_latency_ns", "p99_latency_ns"],
+                        ["shm", 1, 80, 100, 200]],
+            "lanes.csv": [["policy", "num_producers", "lane", "p50_latency_ns", "p99_latency_ns", "p999_latency_ns", "throughput_mps"],
+                          ["strict", 1, 0, 1, 2, 3, 70], ["strict", 1, 1, 1, 2, 3, 70]],
+            "sink.csv": [["mode", "num_producers", "throughput_gbps", "consumer_cpu_s_per_gb"], ["uring", 1, 2.0, 0.1]],
+            "coro.csv": [["logical_producers", "threads", "throughput_mps", "suspensions", "resumes"], [1024, 1, 60, 0, 0]],
+        }
+        for name, rows in files.items():
+            with open(os.path.join(directory, name), "w", newline="") as f:
+                csv.writer(f).writerows(rows)
+
+        groups, _ = load(default_csvs(directory))
+        expected = {("optimized", 1, 0): [100.0, 110.0], ("optimized", 2, 0): [90.0], ("spill", 1, 0): [50.0]}
+        actual = {key: group.samples for key, group in groups.items()}
+        if actual != expected:
+            print(f"load: expected {expected}, got {actual}")
+            return 1
+
+        # overhead: a bounded small cost passes, an unbounded (noisy, few samples) or large one fails.
+        def sweep(name, scale, noise, repeats):
+            rows = [MAIN_COLUMNS + ["cpu_s_per_mmsg", "busy_threads", "jain_index"]]
+            for producers in (1, 2, 4, 8):
+                for i in range(repeats):
+                    rows.append(["optimized", producers, 1e6 * scale * (1 + noise * ((i * 7 + producers) % 5 - 2) / 2), 1, 0, 1])
+            with open(os.path.join(directory, name), "w", newline="") as f:
+                csv.writer(f).writerows(rows)
+            return os.path.join(directory, name)
+
+        cases = [("small", 0.998, 0.002, 15, 0), ("noisy", 1.0, 0.04, 3, 1), ("large", 0.95, 0.002, 15, 1)]
+        for name, scale, noise, repeats, expected_status in cases:
+            base = sweep(f"base-{name}.csv", 1.0, noise, repeats)
+            variant = sweep(f"variant-{name}.csv", scale, noise, repeats)
+            with open(os.devnull, "w") as devnull, contextlib.redirect_stdout(devnull):
+                status = overhead(argparse.Namespace(base=base, variant=variant, budget=0.01, report_only=False))
+            if status != expected_status:
+                print(f"overhead ({name}): expected exit status {expected_status}, got {status}")
+                return 1
+    print("Self-check passed")
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Benchmark statistics")
+    commands = parser.add_subparsers(dest="command", required=True)
+
+    p = commands.add_parser("summarize")
+    p.add_argument("csv", nargs="*")
+    p.set_defaults(func=summarize)
+
+    p = commands.add_parser("save")
+    p.add_argument("--baseline", default=BASELINE_DIR)
+    p.set_defaults(func=save)
+
+    p = commands.add_parser("compare")
+    p.add_argument("csv", nargs="*")
+    p.add_argument("--baseline", default=BASELINE_DIR)
+    p.add_argument("--threshold", type=float, default=0.05, help="smallest relative change worth flagging")
+    p.add_argument("--alpha", type=float, default=0.05, help="significance level of Welch's t-test")
+    p.set_defaults(func=compare)
+
+    p = commands.add_parser("overhead")
+    p.add_argument("base")
+    p.add_argument("variant")
+    p.add_argument("--budget", type=float, default=0.01, help="largest acceptable relative throughput loss")
+    p.add_argument("--report-only", action="store_true", help="print the overhead, never fail")
+    p.set_defaults(func=overhead)
+
+    p = commands.add_parser("selfcheck")
+    p.set_defaults(func=selfcheck)
+
+    p = commands.add_parser("plot")
+    p.add_argument("--out", default=FIGURES_DIR)
+    p.set_defaults(func=plot)
+
+    args = parser.parse_args()
+    sys.exit(args.func(args) or 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,71 @@
+#include "common.hpp"
+
+#define COPY_BYTES 1073741824
+#define MIN_COPY_SIZE 64
+#define MAX_COPY_SIZE 65536
+
+
+//* Writes COPY_BYTES into a ring-sized buffer in Size-byte pieces, optionally reading each piece back
+//* right away the way the consumer would. Returns GB/s.
+double copyBench(CopyKernelT kernel, char *ring, const char *source, size_t size, bool readSoon)
+{
+    size_t offset = 0;
+    volatile uint64_t sink = 0;
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+    for (size_t copied = 0; copied < COPY_BYTES; copied += size) {
+        if (offset + size > RING_SIZE) {
+            offset = 0;
+        }
+        kernel(ring + offset, source, size);
+
+        if (readSoon) {
+            uint64_t sum = 0;
+            for (size_t i = 0; i + sizeof(uint64_t) <= size; i += CACHE_LINE) {
+                sum += *(uint64_t *)(ring + offset + i);
+            }
+            sink += sum;
+        }
+        offset += size;
+    }
+    auto endTime = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime);
+
+    return (double)COPY_BYTES / (duration.count() / 1000000.0) / 1e9;
+}
+
+int main(int argc, char *argv[]) {
+    std::vector<CopyKernels> kernels = AvailableCopyKernels();
+    std::cout << "Selected kernel:\t" << SelectedCopyKernels().Name << std::endl;
+
+    char *ring = new char[RING_SIZE + CACHE_LINE];
+    char *source = new char[MAX_COPY_SIZE];
+    memset(ring, 0, RING_SIZE + CACHE_LINE);
+    memset(source, 'A', MAX_COPY_SIZE);
+
+    std::vector<std::vector<std::string>> data;
+    std::string filename = "data/copy.csv";
+    std::vector<std::string> header = {"kernel", "message_size", "read_soon", "throughput_gbps"};
+    data.push_back(header);
+
+    for (size_t size = MIN_COPY_SIZE; size <= MAX_COPY_SIZE; size *= 2) {
+        std::cout << "Message size:\t" << size << " B" << std::endl;
+        for (int readSoon = 0; readSoon <= 1; readSoon++) {
+            for (auto &kernel : kernels) {
+                std::vector<double> throughputs;
+                for (int i = 0; i < REPEATS; i++) {
+                    throughputs.push_back(copyBench(kernel.Stream, ring, source, size, readSoon));
+                    data.push_back({kernel.Name, std::to_string(size), std::to_string(readSoon), std::to_string(throughputs.back())});
+                }
+                double avg = std::accumulate(throughputs.begin(), throughputs.end(), 0.0) / throughputs.size();
+                std::cout << "\t" << kernel.Name << (readSoon? " (read soon)" : " (drain)") << ":\t" << avg << " GB/s" << std::endl;
+            }
+        }
+        writeCSV(filename, data);
+    }
+
+    delete[] ring;
+    delete[] source;
+
+    return EXIT_SUCCESS;
+}
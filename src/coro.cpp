@@ -0,0 +1,105 @@
+#include "common.hpp"
+#include "coro.hpp"
+
+#define CORO_MESSAGES 10000000
+#define MAX_LOGICAL_PRODUCERS 16384
+
+
+struct CoroResult {
+    double Throughput;
+    unsigned long long Suspensions;
+    size_t Resumes;
+};
+
+Task producerTask(AsyncRing *async, size_t numMessages)
+{
+    for (size_t i = 0; i < numMessages; i++)
+        co_await async->Insert((BufferT)MESSAGE, sizeof(MESSAGE));
+}
+
+//* Frames are walked in the fetched copy; their headers hold the padded frame size.
+Task consumerTask(AsyncRing *async, size_t totalMessages, bool verify, double *throughput)
+{
+    char *payloadBuf = new char[RING_SIZE];
+    size_t receivedCount = 0;
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+    while (receivedCount < totalMessages) {
+        MessageSizeT fetchedBytes = co_await async->Fetch((BufferT)payloadBuf);
+        for (MessageSizeT offset = 0; offset < fetchedBytes; offset += *(MessageSizeT *)(payloadBuf + offset)) {
+            if (verify && memcmp(payloadBuf + offset + sizeof(MessageSizeT), MESSAGE, MESSAGE_SIZE)) {
+                std::cout << "Corrupted message!" << std::endl;
+                exit(EXIT_FAILURE);
+            }
+            receivedCount++;
+        }
+    }
+    auto endTime = std::chrono::high_resolution_clock::now();
+
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
+    std::cout << "\tDuration:\t" << duration.count() << " ms" << std::endl;
+    *throughput = (double)receivedCount / (duration.count() / 1000.0);
+    delete[] payloadBuf;
+}
+
+//* Logical producers are dealt round-robin onto numThreads executors; the consumer has an executor of its own.
+CoroResult run(uint numLogical, uint numThreads, bool verify)
+{
+    BufferT buffer = new char[sizeof(RingBuffer) + CACHE_LINE];
+    RingBuffer* ringBuffer = AllocateMessageBuffer(buffer);
+    AsyncRing *async = new AsyncRing;
+    InitAsyncRing(async, ringBuffer);
+
+    size_t perProducer = CORO_MESSAGES / numLogical;
+    std::vector<Executor> executors(numThreads + 1);
+    for (uint id = 0; id < numLogical; id++) {
+        Spawn(&executors[id % numThreads], producerTask(async, perProducer));
+    }
+    CoroResult result = {0, 0, 0};
+    Spawn(&executors[numThreads], consumerTask(async, perProducer * numLogical, verify, &result.Throughput));
+
+    std::vector<std::thread> threads;
+    for (auto &executor : executors) {
+        threads.push_back(std::thread(RunExecutor, &executor));
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    result.Suspensions = async->Suspensions.load();
+    for (auto &executor : executors) {
+        result.Resumes += executor.Resumes;
+    }
+
+    delete async;
+    DeallocateMessageBuffer(ringBuffer);
+    delete[] buffer;
+
+    return result;
+}
+
+int main(int argc, char *argv[]) {
+    bool verify = (argc > 1)? atoi(argv[1]) : false;
+    std::cout << "Check:\t" << verify << std::endl;
+
+    std::vector<std::vector<std::string>> data;
+    std::string filename = "data/coro.csv";
+    std::vector<std::string> header = {"logical_producers", "threads", "throughput_mps", "suspensions", "resumes"};
+    data.push_back(header);
+
+    for (int numThreads = 1; numThreads <= TOTAL_CORES/4; numThreads *= 2) {
+        std::cout << "Producer threads:\t" << numThreads << std::endl;
+        for (int numLogical = numThreads; numLogical <= MAX_LOGICAL_PRODUCERS; numLogical *= 4) {
+            std::cout << "Logical producers:\t" << numLogical << std::endl;
+            for (int i = 0; i < REPEATS; i++) {
+                CoroResult result = run(numLogical, numThreads, verify);
+                std::cout << "\tThroughput:\t" << result.Throughput << " MPS, " << result.Suspensions << " suspensions" << std::endl;
+                data.push_back({std::to_string(numLogical), std::to_string(numThreads), std::to_string(result.Throughput),
+                                std::to_string(result.Suspensions), std::to_string(result.Resumes)});
+                writeCSV(filename, data);
+            }
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,152 @@
+#include "common.hpp"
+#include "lanes.hpp"
+
+#define CONTROL_MESSAGES 20000
+#define CONTROL_INTERVAL_US 20
+#define CONTROL_SIZE 16
+#define BULK_SIZE 1020
+#define LANE_BATCH 64
+#define NUM_LANES 2
+
+
+//* Payload header: send time, the priority it was sent with, and the sender's id and sequence number,
+//* so a frame read before it was committed (or committed out of order) stops the run instead of skewing latencies.
+struct LaneHeader {
+    long SentNs;
+    char Priority;
+    unsigned short Producer;
+    unsigned int Sequence;
+};
+
+long nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::atomic<bool> gStop;
+
+//* Latency-critical traffic at a fixed rate on lane 0, sent as producer 0.
+void controlProducer(LaneGroup *group)
+{
+    char message[CONTROL_SIZE] = {0};
+    LaneHeader header = {0, 0, 0, 0};
+    for (size_t i = 0; i < CONTROL_MESSAGES; i++) {
+        long due = nowNs() + CONTROL_INTERVAL_US * 1000;
+        header.SentNs = nowNs();
+        header.Sequence = i;
+        memcpy(message, &header, sizeof(header));
+        while (!LaneInsertToMessageBuffer(group, 0, message, CONTROL_SIZE) && !gStop)
+            ;
+        while (nowNs() < due)
+            ;
+    }
+}
+
+//* Saturating bulk traffic on the last lane until the control stream is done.
+void bulkProducer(LaneGroup *group, unsigned short id)
+{
+    std::vector<char> message(BULK_SIZE, 'B');
+    LaneHeader header = {0, NUM_LANES - 1, id, 0};
+    while (!gStop) {
+        header.SentNs = nowNs();
+        memcpy(message.data(), &header, sizeof(header));
+        while (!gStop) {
+            if (LaneInsertToMessageBuffer(group, NUM_LANES - 1, message.data(), BULK_SIZE)) {
+                header.Sequence++;
+                break;
+            }
+        }
+    }
+}
+
+long percentile(std::vector<long> &samples, double p)
+{
+    if (samples.empty()) return 0;
+    std::sort(samples.begin(), samples.end());
+    return samples[std::min(samples.size() - 1, (size_t)(samples.size() * p))];
+}
+
+//* Returns per-priority latency samples; the class is read from the payload so a single shared lane works too.
+std::vector<std::vector<long>> run(int numLanes, LanePolicy policy, uint numBulkProducers, double *throughput)
+{
+    LaneGroup group;
+    unsigned int weights[MAX_LANES] = {LANE_BATCH, 1, 1, 1};
+    AllocateLaneGroup(&group, numLanes, policy, weights);
+    gStop = false;
+
+    std::vector<std::vector<long>> latencies(NUM_LANES);
+    size_t controlReceived = 0;
+    size_t received = 0;
+    std::vector<unsigned int> expected(numBulkProducers + 1, 0);
+    auto visitor = [&](int lane, BufferT messagePtr, MessageSizeT messageSize) {
+        LaneHeader header;
+        memcpy(&header, messagePtr, sizeof(header));
+        if (header.Producer >= expected.size() || header.Sequence != expected[header.Producer]) {
+            std::cout << "Frame out of order on lane " << lane << " (producer " << header.Producer << ", sequence "
+                      << header.Sequence << ")" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        expected[header.Producer]++;
+        latencies[header.Priority].push_back(nowNs() - header.SentNs);
+        if (header.Priority == 0) controlReceived++;
+        received++;
+    };
+
+    std::vector<std::thread> threads;
+    for (uint id = 0; id < numBulkProducers; id++) {
+        threads.push_back(std::thread(bulkProducer, &group, id + 1));
+    }
+    threads.push_back(std::thread(controlProducer, &group));
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+    while (controlReceived < CONTROL_MESSAGES) {
+        ConsumeLanes(&group, visitor, LANE_BATCH);
+    }
+    auto endTime = std::chrono::high_resolution_clock::now();
+    gStop = true;
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    DeallocateLaneGroup(&group);
+
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
+    *throughput = (double)received / (duration.count() / 1000.0);
+    return latencies;
+}
+
+int main(int argc, char *argv[]) {
+    std::vector<std::vector<std::string>> data;
+    std::string filename = "data/lanes.csv";
+    std::vector<std::string> header = {"policy", "num_producers", "lane", "p50_latency_ns", "p99_latency_ns", "p999_latency_ns", "throughput_mps"};
+    data.push_back(header);
+
+    struct { std::string name; int lanes; LanePolicy policy; } policies[] = {
+        {"shared", 1, STRICT_PRIORITY},
+        {"strict", NUM_LANES, STRICT_PRIORITY},
+        {"weighted", NUM_LANES, WEIGHTED_FAIR},
+    };
+
+    for (auto &policy : policies) {
+        std::cout << "Policy:\t" << policy.name << std::endl;
+        for (int numProducers = 1; numProducers <= TOTAL_CORES/2; numProducers *= 2) {
+            std::cout << "Number of bulk producers:\t" << numProducers << std::endl;
+            for (int i = 0; i < REPEATS; i++) {
+                double throughput;
+                std::vector<std::vector<long>> latencies = run(policy.lanes, policy.policy, numProducers, &throughput);
+                for (int lane = 0; lane < NUM_LANES; lane++) {
+                    long p50 = percentile(latencies[lane], 0.5);
+                    long p99 = percentile(latencies[lane], 0.99);
+                    long p999 = percentile(latencies[lane], 0.999);
+                    std::cout << "\tLane " << lane << ":\tp50 " << p50 << " ns, p99 " << p99 << " ns, p99.9 " << p999 << " ns" << std::endl;
+                    data.push_back({policy.name, std::to_string(numProducers), std::to_string(lane),
+                                    std::to_string(p50), std::to_string(p99), std::to_string(p999), std::to_string(throughput)});
+                }
+                writeCSV(filename, data);
+            }
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
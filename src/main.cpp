@@ -6,60 +6,232 @@
 #include "tail.hpp"
 #include "yield.hpp"
 #include "free.hpp"
+#include "broadcast.hpp"
+#include "typed.hpp"
+#include "single.hpp"
+#include "spsc.hpp"
+#include "spill.hpp"
+#include "deadline.hpp"
+#include "ticket.hpp"
+#include "elastic.hpp"
+#include "sampler.hpp"
+#include "integrity.hpp"
 
+#include <sys/resource.h>
+#include <memory>
 
-using InsertFunctionT = bool (*)(RingBuffer*, const BufferT, MessageSizeT);
+#define SPILL_PATH "data/spill.log"
+#define SPILL_STALL_MS 200
+#define ELASTIC_STALL_MS 50
+#define INSERT_TIMEOUT std::chrono::seconds(1)
+#define CONSUME_TIMEOUT std::chrono::milliseconds(10)
+#define LATENCY_SAMPLE 64
+//* With fault injection, every FAULT_INTERVAL-th message of a producer is dropped, duplicated or torn, in turn.
+#define FAULT_INTERVAL 100003
 
-void producer(InsertFunctionT insertFunc, RingBuffer *ringBuffer, uint id) 
+//* Levels of the <check> argument; the integrity levels need a mode driven by runRing.
+#define CHECK_NONE 0
+#define CHECK_PAYLOAD 1
+#define CHECK_INTEGRITY 2
+#define CHECK_FAULTS 3
+
+
+//* Per-producer accounting, one cache line each so the counters do not contend.
+struct alignas(CACHE_LINE) ProducerStats {
+    std::atomic<size_t> Delivered;
+    std::vector<long> Latencies;
+};
+
+ProducerStats *gProducerStats = nullptr;
+uint gNumProducerStats = 0;
+//* Delivered counts when the first producer finished: until then every producer had the same chance to insert.
+std::vector<size_t> gDeliveredSnapshot;
+std::atomic<bool> gFirstDone;
+
+//* Replaces the stats of the previous run. Aligned by hand: before C++17, new ignores the alignment of ProducerStats.
+void resetProducerStats(uint numProducers)
+{
+    for (uint id = 0; id < gNumProducerStats; id++) {
+        gProducerStats[id].~ProducerStats();
+    }
+    free(gProducerStats);
+
+    void *memory = nullptr;
+    if (posix_memalign(&memory, CACHE_LINE, numProducers * sizeof(ProducerStats))) {
+        std::cerr << "Error allocating producer stats" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    gProducerStats = (ProducerStats *)memory;
+    for (uint id = 0; id < numProducers; id++) {
+        new (&gProducerStats[id]) ProducerStats();
+    }
+    gNumProducerStats = numProducers;
+}
+
+enum FaultT {
+    FAULT_DROP,
+    FAULT_DUPLICATE,
+    FAULT_TEAR,
+    NUM_FAULTS
+};
+
+//* Faults the producers injected, and what the consumer's integrity check found.
+std::atomic<size_t> gInjectedFaults[NUM_FAULTS];
+IntegrityCheckerT gIntegrity;
+
+//* Seals the next message into Sealed, injecting a fault every FAULT_INTERVAL messages: a dropped frame skips a
+//* sequence number, a duplicated one resends the previous message (still in Sealed) and a torn one flips a payload byte.
+void sealNext(IntegritySealerT *sealer, char *sealed, size_t i, bool injectFaults)
+{
+    if (!injectFaults || i % FAULT_INTERVAL != FAULT_INTERVAL - 1) {
+        SealMessage(sealer, MESSAGE, sizeof(MESSAGE), sealed);
+        return;
+    }
+
+    FaultT fault = (FaultT)(i / FAULT_INTERVAL % NUM_FAULTS);
+    if (fault == FAULT_DROP) {
+        sealer->NextSequence++;
+    }
+    if (fault != FAULT_DUPLICATE) {
+        SealMessage(sealer, MESSAGE, sizeof(MESSAGE), sealed);
+    }
+    if (fault == FAULT_TEAR) {
+        sealed[sizeof(IntegrityHeaderT)] ^= 0x5A;
+    }
+    gInjectedFaults[fault]++;
+}
+
+void producer(InsertFunctionT insertFunc, RingBuffer *ringBuffer, uint id, bool blocking, int check) 
+{
+    ProducerStats &stats = gProducerStats[id];
+    IntegritySealerT sealer;
+    InitIntegritySealer(&sealer, id);
+    char sealed[sizeof(IntegrityHeaderT) + sizeof(MESSAGE)];
+    BufferT message = (check >= CHECK_INTEGRITY)? sealed : (BufferT)MESSAGE;
+    MessageSizeT messageBytes = (check >= CHECK_INTEGRITY)? IntegrityMessageBytes(sizeof(MESSAGE)) : sizeof(MESSAGE);
+
+    for (size_t i = 0; i < NUM_MESSAGES; i++) {
+        //* Insert latency (including retries) of every LATENCY_SAMPLE-th message.
+        bool sampled = i % LATENCY_SAMPLE == 0;
+        auto startTime = (sampled)? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+
+        if (check >= CHECK_INTEGRITY) {
+            sealNext(&sealer, sealed, i, check == CHECK_FAULTS);
+        }
+        if (blocking) {
+            //* Waits inside InsertFor instead of busy-retrying; a timeout only means the consumer is slow.
+            while(!InsertFor(insertFunc, ringBuffer, message, messageBytes, INSERT_TIMEOUT))
+                ;
+        } else {
+            while(!insertFunc(ringBuffer, message, messageBytes))
+                ;
+        }
+
+        if (sampled) {
+            stats.Latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - startTime).count());
+        }
+        stats.Delivered.store(i + 1, std::memory_order_relaxed);
+    }
+
+    if (!gFirstDone.exchange(true)) {
+        for (size_t other = 0; other < gDeliveredSnapshot.size(); other++) {
+            gDeliveredSnapshot[other] = gProducerStats[other].Delivered.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void consumer(RingBuffer *ringBuffer, uint numProducers, int check, bool blocking) 
+{
+    size_t receivedCount = 0;
+    size_t measuredCount = 0;
+    bool warmedUp = false;
+    IntegrityCheckerT checker;
+    InitIntegrityChecker(&checker, numProducers);
+
+    //* Frames are visited in place; no copy into a payload buffer.
+    auto visitor = [&](BufferT messagePtr, MessageSizeT messageSize) {
+        //* Failed integrity checks are counted and reported by runRing, the payload check stops at the first one.
+        if (check >= CHECK_INTEGRITY) {
+            CheckIntegrity(&checker, messagePtr, messageSize);
+        } else if (check == CHECK_PAYLOAD && (messageSize != PAYLOAD_SIZE || memcmp(messagePtr, MESSAGE, MESSAGE_SIZE))) {
+            std::cout << "Corrupted message!" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+    };
+
+    std::chrono::high_resolution_clock::time_point startTime;
+    while (receivedCount < NUM_MESSAGES * numProducers) {
+        size_t consumed = (blocking)? ConsumeFor(ringBuffer, visitor, CONSUME_BATCH, CONSUME_TIMEOUT)
+                                    : ConsumeMessages(ringBuffer, visitor, CONSUME_BATCH);
+        if (!consumed) {
+            continue;
+        }
+        receivedCount += consumed;
+        measuredCount += consumed;
+
+        //* Start measuring throughput after warmup.
+        if (!warmedUp && receivedCount >= WARMUP_MESSAGES) {
+            startTime = std::chrono::high_resolution_clock::now();
+            measuredCount = 0;
+            warmedUp = true;
+        }
+    }
+
+    //* Calculate throughput 
+    auto endTime = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
+    std::cout << "\tDuration:\t" << duration.count() << " ms" << std::endl;
+    gThroughput = (double)(measuredCount) / (duration.count() / 1000.0);
+    gIntegrity = checker;
+}
+
+void broadcastProducer(BroadcastRing *ringBuffer, uint id) 
 {
     for (size_t i = 0; i < NUM_MESSAGES; i++)
-        while(!insertFunc(ringBuffer, (BufferT)MESSAGE, sizeof(MESSAGE)))
+        while(!BroadcastInsertToMessageBuffer(ringBuffer, (BufferT)MESSAGE, sizeof(MESSAGE)))
             ;
 }
 
-void consumer(RingBuffer *ringBuffer, uint numProducers, bool verify) 
+void subscriber(BroadcastRing *ringBuffer, int id, uint numProducers, bool verify, double *throughput) 
 {
-    char *payloadBuf = new char[RING_SIZE];
-    memset(payloadBuf, 0, RING_SIZE);
-    MessageSizeT fetchedBytes;
+    BufferT region;
+    MessageSizeT regionSize;
     size_t receivedCount = 0;
     size_t measuredCount = 0;
+    RingSizeT peakLag = 0;
     bool warmedUp = false;
 
     std::chrono::high_resolution_clock::time_point startTime;
     while (receivedCount < NUM_MESSAGES * numProducers) {
-        if (!FetchFromMessageBuffer(ringBuffer, (BufferT)payloadBuf, &fetchedBytes)) {
+        if (!BroadcastFetch(ringBuffer, id, &region, &regionSize)) {
             continue;
         }
 
+        RingSizeT lag = BroadcastLag(ringBuffer, id);
+        if (lag > peakLag) peakLag = lag;
+
+        //* Frames are parsed in place; nothing is copied out of the ring.
         MessageSizeT messageSize = 0;
-        MessageSizeT remainingSize = fetchedBytes;
-        char *messagePtr = payloadBuf;
-        char *startOfNext = payloadBuf;
+        MessageSizeT remainingSize = regionSize;
+        char *framePtr = region;
+        char *messagePtr = region;
+        char *startOfNext = region;
         do {
-            //* Parse the message and determine the next message start and remaining size
-            ParseNextMessage(payloadBuf, fetchedBytes, &messagePtr, &messageSize, &startOfNext, &remainingSize);
-
-            //* Verify the correctness of the message.
-            if (verify) {
-                try {
-                    if (messageSize != PAYLOAD_SIZE || memcmp(messagePtr, MESSAGE, MESSAGE_SIZE)) {
-                        std::cout << "Corrupted message!" << std::endl;
-                        exit(EXIT_FAILURE);
-                    }
-                } catch (const std::exception &e) {
-                    std::cout << "Exception: " << e.what() << std::endl;
-                    exit(EXIT_FAILURE);
-                }
+            ParseNextMessage(framePtr, remainingSize, &messagePtr, &messageSize, &startOfNext, &remainingSize);
+
+            if (verify && (messageSize != PAYLOAD_SIZE || memcmp(messagePtr, MESSAGE, MESSAGE_SIZE))) {
+                std::cout << "Corrupted message!" << std::endl;
+                exit(EXIT_FAILURE);
             }
 
-            messagePtr = startOfNext;
-            fetchedBytes = remainingSize;
+            framePtr = startOfNext;
             receivedCount++;
             measuredCount++;
         } while (remainingSize > 0);
 
-        //* Start measuring throughput after warmup.
+        BroadcastRelease(ringBuffer, id, regionSize);
+
         if (!warmedUp && receivedCount >= WARMUP_MESSAGES) {
             startTime = std::chrono::high_resolution_clock::now();
             measuredCount = 0;
@@ -67,91 +239,568 @@ void consumer(RingBuffer *ringBuffer, uint numProducers, bool verify)
         }
     }
 
-    //* Calculate throughput 
+    auto endTime = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
+    std::cout << "\tSubscriber " << id << ":\t" << duration.count() << " ms, peak lag " << peakLag << " B" << std::endl;
+    *throughput = (double)(measuredCount) / (duration.count() / 1000.0);
+}
+
+//* Every subscriber sees the whole stream; the throughput of the slowest one is reported.
+void runBroadcast(uint numProducers, bool verify) 
+{
+    BufferT buffer = new char[sizeof(BroadcastRing) + CACHE_LINE];
+    BroadcastRing* ringBuffer = AllocateBroadcastBuffer(buffer);
+    std::vector<std::thread> threads;
+    std::vector<double> throughputs(NUM_SUBSCRIBERS, 0);
+
+    for (int i = 0; i < NUM_SUBSCRIBERS; i++) {
+        BroadcastSubscribe(ringBuffer);
+    }
+    for (uint id = 0; id < numProducers; id++) {
+        threads.push_back(std::thread(broadcastProducer, ringBuffer, id));
+    }
+    for (int i = 0; i < NUM_SUBSCRIBERS; i++) {
+        threads.push_back(std::thread(subscriber, ringBuffer, i, numProducers, verify, &throughputs[i]));
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    DeallocateBroadcastBuffer(ringBuffer);
+    delete[] buffer;
+
+    gThroughput = *std::min_element(throughputs.begin(), throughputs.end());
+}
+
+//* Same 8-byte payload as MESSAGE, stored in fixed slots instead of 64-byte frames.
+struct TypedMessage {
+    char Payload[MESSAGE_SIZE];
+};
+typedef TypedRing<TypedMessage, RING_SIZE / sizeof(TypedMessage)> TypedRingT;
+
+void typedProducer(TypedRingT *ringBuffer, uint id) 
+{
+    TypedMessage message;
+    memcpy(message.Payload, MESSAGE, MESSAGE_SIZE);
+    for (size_t i = 0; i < NUM_MESSAGES; i++)
+        while(!TypedInsert(ringBuffer, message))
+            ;
+}
+
+void typedConsumer(TypedRingT *ringBuffer, uint numProducers, bool verify) 
+{
+    std::vector<TypedMessage> messages(CONSUME_BATCH);
+    size_t receivedCount = 0;
+    size_t measuredCount = 0;
+    bool warmedUp = false;
+
+    std::chrono::high_resolution_clock::time_point startTime;
+    while (receivedCount < NUM_MESSAGES * numProducers) {
+        unsigned int fetched = TypedFetchBulk(ringBuffer, messages.data(), CONSUME_BATCH);
+        if (!fetched) {
+            continue;
+        }
+
+        if (verify) {
+            for (unsigned int i = 0; i < fetched; i++) {
+                if (memcmp(messages[i].Payload, MESSAGE, MESSAGE_SIZE)) {
+                    std::cout << "Corrupted message!" << std::endl;
+                    exit(EXIT_FAILURE);
+                }
+            }
+        }
+        receivedCount += fetched;
+        measuredCount += fetched;
+
+        if (!warmedUp && receivedCount >= WARMUP_MESSAGES) {
+            startTime = std::chrono::high_resolution_clock::now();
+            measuredCount = 0;
+            warmedUp = true;
+        }
+    }
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
+    std::cout << "\tDuration:\t" << duration.count() << " ms" << std::endl;
+    gThroughput = (double)(measuredCount) / (duration.count() / 1000.0);
+}
+
+void runTyped(uint numProducers, bool verify) 
+{
+    BufferT buffer = new char[sizeof(TypedRingT) + CACHE_LINE];
+    TypedRingT* ringBuffer = AllocateTypedBuffer<TypedMessage, RING_SIZE / sizeof(TypedMessage)>(buffer);
+    std::vector<std::thread> threads;
+    gNumProducers = numProducers;
+
+    for (uint id = 0; id < numProducers; id++) {
+        threads.push_back(std::thread(typedProducer, ringBuffer, id));
+    }
+    threads.push_back(std::thread(typedConsumer, ringBuffer, numProducers, verify));
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    DeallocateTypedBuffer(ringBuffer);
+    delete[] buffer;
+}
+
+unsigned long long gSpillPeakBytes;
+double gSpillRecoveryMs;
+
+void spillProducer(RingBuffer *ringBuffer, SpillLog *spill, uint id) 
+{
+    for (size_t i = 0; i < NUM_MESSAGES; i++)
+        while(!SpillInsertToMessageBuffer(&OptimizedInsertToMessageBuffer, ringBuffer, spill, (BufferT)MESSAGE, sizeof(MESSAGE)))
+            ;
+}
+
+//* Stalls once after warmup to simulate a burst, then drains the ring first and the spill log once the ring is empty.
+void spillConsumer(RingBuffer *ringBuffer, SpillLog *spill, uint numProducers, bool verify) 
+{
+    size_t receivedCount = 0;
+    size_t measuredCount = 0;
+    bool warmedUp = false;
+    bool recovered = false;
+
+    auto visitor = [&](BufferT messagePtr, MessageSizeT messageSize) {
+        if (verify && (messageSize != PAYLOAD_SIZE || memcmp(messagePtr, MESSAGE, MESSAGE_SIZE))) {
+            std::cout << "Corrupted message!" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+    };
+
+    std::chrono::high_resolution_clock::time_point startTime;
+    std::chrono::high_resolution_clock::time_point resumeTime;
+    gSpillRecoveryMs = 0;
+    while (receivedCount < NUM_MESSAGES * numProducers) {
+        size_t consumed = ConsumeMessages(ringBuffer, visitor, CONSUME_BATCH);
+        if (!consumed && RingDrained(ringBuffer)) {
+            consumed = ConsumeSpill(spill, visitor, CONSUME_BATCH);
+        }
+        receivedCount += consumed;
+        measuredCount += consumed;
+
+        if (warmedUp && !recovered && !SpillActive(spill)) {
+            gSpillRecoveryMs = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::high_resolution_clock::now() - resumeTime).count() / 1000.0;
+            recovered = true;
+        }
+
+        if (!warmedUp && receivedCount >= WARMUP_MESSAGES) {
+            startTime = std::chrono::high_resolution_clock::now();
+            measuredCount = 0;
+            warmedUp = true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(SPILL_STALL_MS));
+            resumeTime = std::chrono::high_resolution_clock::now();
+        }
+    }
+
     auto endTime = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
     std::cout << "\tDuration:\t" << duration.count() << " ms" << std::endl;
     gThroughput = (double)(measuredCount) / (duration.count() / 1000.0);
 }
 
+void runSpill(uint numProducers, bool verify) 
+{
+    BufferT buffer = new char[sizeof(RingBuffer) + CACHE_LINE];
+    RingBuffer* ringBuffer = AllocateMessageBuffer(buffer);
+    SpillLog spill;
+    std::vector<std::thread> threads;
+
+    if (!OpenSpillLog(&spill, SPILL_PATH, SPILL_LIMIT)) {
+        exit(EXIT_FAILURE);
+    }
+
+    for (uint id = 0; id < numProducers; id++) {
+        threads.push_back(std::thread(spillProducer, ringBuffer, &spill, id));
+    }
+    threads.push_back(std::thread(spillConsumer, ringBuffer, &spill, numProducers, verify));
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    gSpillPeakBytes = spill.PeakBytes[0];
+    std::cout << "\tSpill:\t" << spill.Generations[0] << " bursts, peak " << gSpillPeakBytes << " B, recovered in " << gSpillRecoveryMs << " ms" << std::endl;
+
+    CloseSpillLog(&spill, SPILL_PATH);
+    DeallocateMessageBuffer(ringBuffer);
+    delete[] buffer;
+}
+
+size_t gElasticPeakBytes;
+size_t gElasticFinalBytes;
+unsigned int gElasticGrows;
+unsigned int gElasticShrinks;
+
+void elasticProducer(ElasticRing *ringBuffer) 
+{
+    int slot = ElasticRegisterProducer(ringBuffer);
+    if (slot < 0) {
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < NUM_MESSAGES; i++)
+        while(!ElasticInsert(ringBuffer, slot, (BufferT)MESSAGE, sizeof(MESSAGE)))
+            ;
+}
+
+//* Stalls once after warmup, so the ring has to grow to absorb the backlog and may shrink once it drained.
+void elasticConsumer(ElasticRing *ringBuffer, uint numProducers, bool verify) 
+{
+    size_t receivedCount = 0;
+    size_t measuredCount = 0;
+    bool warmedUp = false;
+
+    auto visitor = [&](BufferT messagePtr, MessageSizeT messageSize) {
+        if (verify && (messageSize != PAYLOAD_SIZE || memcmp(messagePtr, MESSAGE, MESSAGE_SIZE))) {
+            std::cout << "Corrupted message!" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+    };
+
+    std::chrono::high_resolution_clock::time_point startTime;
+    while (receivedCount < NUM_MESSAGES * numProducers) {
+        size_t consumed = ConsumeElastic(ringBuffer, visitor, CONSUME_BATCH);
+        receivedCount += consumed;
+        measuredCount += consumed;
+
+        if (!warmedUp && receivedCount >= WARMUP_MESSAGES) {
+            startTime = std::chrono::high_resolution_clock::now();
+            measuredCount = 0;
+            warmedUp = true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(ELASTIC_STALL_MS));
+        }
+    }
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
+    std::cout << "\tDuration:\t" << duration.count() << " ms" << std::endl;
+    gThroughput = (double)(measuredCount) / (duration.count() / 1000.0);
+}
+
+void runElastic(uint numProducers, bool verify) 
+{
+    ElasticRing *ringBuffer = new ElasticRing;
+    InitElasticRing(ringBuffer, ELASTIC_MIN);
+    std::vector<std::thread> threads;
+
+    for (uint id = 0; id < numProducers; id++) {
+        threads.push_back(std::thread(elasticProducer, ringBuffer));
+    }
+    threads.push_back(std::thread(elasticConsumer, ringBuffer, numProducers, verify));
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    gElasticPeakBytes = ringBuffer->PeakFootprint;
+    gElasticFinalBytes = ringBuffer->Footprint;
+    std::cout << "\tFootprint:\tpeak " << gElasticPeakBytes << " B, final " << gElasticFinalBytes << " B, "
+              << ringBuffer->Grows << " grows, " << ringBuffer->Shrinks << " shrinks" << std::endl;
+    gElasticGrows = ringBuffer->Grows;
+    gElasticShrinks = ringBuffer->Shrinks;
+
+    DestroyElasticRing(ringBuffer);
+    delete ringBuffer;
+}
+
+void runRing(InsertFunctionT insertFunc, const std::string &mode, uint numProducers, int check) 
+{
+    std::vector<std::thread> threads;
+    //* Allocate the ring buffer.
+    BufferT buffer = new char[sizeof(RingBuffer) + CACHE_LINE];
+    RingBuffer* ringBuffer = AllocateMessageBuffer(buffer);
+    if (mode != "tail" && mode != "optimized" && mode != "blocking" && mode != "ticket") ringBuffer->Tail.store(-1);
+    //* SPSC path with one producer, optimized otherwise.
+    if (mode == "auto") insertFunc = RegisterProducers(ringBuffer, numProducers);
+
+#ifdef TRACE
+    TraceReset();
+#endif
+#ifdef TELEMETRY
+    TelemetrySampler sampler;
+    StartTelemetry(&sampler, ringBuffer, TELEMETRY_SHM_NAME, TELEMETRY_PROM_PATH);
+#endif
+    resetProducerStats(numProducers);
+    gDeliveredSnapshot.assign(numProducers, 0);
+    gFirstDone = false;
+    for (int fault = 0; fault < NUM_FAULTS; fault++) {
+        gInjectedFaults[fault] = 0;
+    }
+    for (uint id = 0; id < numProducers; id++) {
+        gProducerStats[id].Delivered = 0;
+        threads.push_back(std::thread(producer, insertFunc, ringBuffer, id, mode == "blocking", check));
+    }
+    threads.push_back(std::thread(consumer, ringBuffer, numProducers, check, mode == "blocking"));
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+#ifdef TELEMETRY
+    StopTelemetry(&sampler);
+#endif
+#ifdef TRACE
+    //* One trace per producer count, the last repeat wins.
+    TraceDump(("data/trace-" + mode + "-" + std::to_string(numProducers) + ".bin").c_str());
+#endif
+
+    //* Every injected fault has to be detected as what it is, and nothing else may fail.
+    if (check >= CHECK_INTEGRITY) {
+        std::cout << "\tIntegrity:\t" << gIntegrity.Passed << " passed, " << gIntegrity.Lost << " lost, "
+                  << gIntegrity.Duplicated << " duplicated, " << gIntegrity.Corrupted << " corrupted" << std::endl;
+        if (gIntegrity.Lost != gInjectedFaults[FAULT_DROP] || gIntegrity.Duplicated != gInjectedFaults[FAULT_DUPLICATE]
+            || gIntegrity.Corrupted != gInjectedFaults[FAULT_TEAR]) {
+            std::cout << "Integrity check failed: injected " << gInjectedFaults[FAULT_DROP] << " dropped, "
+                      << gInjectedFaults[FAULT_DUPLICATE] << " duplicated, " << gInjectedFaults[FAULT_TEAR] << " torn" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    //* Deallocate the ring buffer
+    DeallocateMessageBuffer(ringBuffer);
+    delete[] buffer;
+}
+
+//* Co-located load: keeps a core busy until the run is over. Its CPU time is kept out of cpu_s_per_mmsg.
+std::atomic<bool> gStopBusy;
+std::atomic<long> gBusyCpuNs;
+
+void busyThread()
+{
+    while (!gStopBusy.load(std::memory_order_relaxed))
+        ;
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    gBusyCpuNs += ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+//* User and system time of the whole process, so spinning producers are charged too.
+double processCpuSeconds()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+}
+
+struct OrderSite {
+    const char *Name;
+    std::memory_order Order;
+    std::memory_order Minimal;
+};
+
+//* The per-site orderings of common.hpp this binary was built with, next to their minimal defaults.
+std::vector<OrderSite> orderSites()
+{
+    return {{"reserve", ORDER_RESERVE, std::memory_order_relaxed},
+            {"head_load", ORDER_HEAD_LOAD, std::memory_order_acquire},
+            {"commit_wait", ORDER_COMMIT_WAIT, std::memory_order_acquire},
+            {"commit", ORDER_COMMIT, std::memory_order_release},
+            {"tail_load", ORDER_TAIL_LOAD, std::memory_order_acquire},
+            {"head_publish", ORDER_HEAD_PUBLISH, std::memory_order_release}};
+}
+
+std::string orderName(std::memory_order order)
+{
+    switch (order) {
+    case std::memory_order_relaxed: return "relaxed";
+    case std::memory_order_consume: return "consume";
+    case std::memory_order_acquire: return "acquire";
+    case std::memory_order_release: return "release";
+    case std::memory_order_acq_rel: return "acq_rel";
+    default: return "seq_cst";
+    }
+}
+
+//* "-<site>_<ordering>" for every site built with a non-default ordering, "-seq_cst" if all of them are.
+std::string orderTag()
+{
+    std::string tag;
+    bool allSeqCst = true;
+    for (const OrderSite &site : orderSites()) {
+        if (site.Order != site.Minimal) {
+            tag += "-" + std::string(site.Name) + "_" + orderName(site.Order);
+        }
+        allSeqCst = allSeqCst && site.Order == std::memory_order_seq_cst;
+    }
+    return (allSeqCst)? "-seq_cst" : tag;
+}
+
+//* Jain's fairness index: 1 when all producers delivered the same, 1/n when one delivered everything.
+double jainIndex(const std::vector<size_t> &counts)
+{
+    double sum = 0;
+    double squares = 0;
+    for (size_t count : counts) {
+        sum += count;
+        squares += (double)count * count;
+    }
+    return (squares)? sum * sum / (counts.size() * squares) : 0;
+}
+
+long percentile(std::vector<long> &samples, double p)
+{
+    if (samples.empty()) return 0;
+    std::sort(samples.begin(), samples.end());
+    return samples[std::min(samples.size() - 1, (size_t)(samples.size() * p))];
+}
+
 int main(int argc, char *argv[]) {
-    bool verify = false;
+    int check = CHECK_NONE;
     std::string mode = "lock";
-    if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <check> [<mode>]" << std::endl;
+    uint numBusy = 0;
+    //* Other values would take the sealed path without the -integrity/-faults suffix and overwrite the unchecked CSV.
+    char *checkEnd = nullptr;
+    if (argc > 1) check = strtol(argv[1], &checkEnd, 10);
+    if (argc < 2 || *checkEnd || checkEnd == argv[1] || check < CHECK_NONE || check > CHECK_FAULTS) {
+        std::cerr << "Usage: " << argv[0] << " <check> [<mode>] [<busy threads>]" << std::endl;
+        std::cerr << "\t<check>: 0 none, 1 payload, 2 sequence and CRC32C, 3 sequence and CRC32C with fault injection" << std::endl;
         exit(1);
     } else {
-        verify = atoi(argv[1]);
-        std::cout << "Check:\t" << verify << std::endl;
+        std::cout << "Check:\t" << check << std::endl;
         mode = argv[2]? argv[2] : mode;
         std::cout << "Mode:\t" << mode << std::endl;
+        numBusy = (argc > 3)? atoi(argv[3]) : 0;
+        std::cout << "Busy threads:\t" << numBusy << std::endl;
     }
     std::cout << "Memory barrier:\t" << (mem_barrier == std::memory_order_relaxed? "relaxed" : "seq const") << std::endl;
+    std::cout << "Orderings:\t";
+    for (const OrderSite &site : orderSites()) {
+        std::cout << site.Name << "=" << orderName(site.Order) << " ";
+    }
+    std::cout << std::endl;
 
-    InsertFunctionT insertFunc;
-    switch (mode[0]) {
-        case 'l':
-            insertFunc = &LockInsertToMessageBuffer;
-            break;
-        case 's':
-            insertFunc = &SpinInsertToMessageBuffer;
-            break;
-        case 'n':
-            insertFunc = &NotifyInsertToMessageBuffer;
-            break;
-        case 'o':
-            insertFunc = &OptimizedInsertToMessageBuffer;
-            break;
-        case 't':
-            insertFunc = &TailInsertToMessageBuffer;
-            break;
-        case 'y':
-            insertFunc = &YieldInsertToMessageBuffer;
-            break;
-        case 'f':
-            insertFunc = &FreeInsertToMessageBuffer;
-            break;
-        default:
-            std::cerr << "Invalid mode: " << mode << std::endl;
-            exit(1);
+    InsertFunctionT insertFunc = nullptr;
+    if (mode == "lock") {
+        insertFunc = &LockInsertToMessageBuffer;
+    } else if (mode == "spin") {
+        insertFunc = &SpinInsertToMessageBuffer;
+    } else if (mode == "notify") {
+        insertFunc = &NotifyInsertToMessageBuffer;
+    } else if (mode == "optimized" || mode == "blocking") {
+        insertFunc = &OptimizedInsertToMessageBuffer;
+    } else if (mode == "tail") {
+        insertFunc = &TailInsertToMessageBuffer;
+    } else if (mode == "ticket") {
+        insertFunc = &TicketInsertToMessageBuffer;
+    } else if (mode == "yield") {
+        insertFunc = &YieldInsertToMessageBuffer;
+    } else if (mode == "free") {
+        insertFunc = &FreeInsertToMessageBuffer;
+    } else if (mode == "single") {
+        insertFunc = &InsertToMessageBuffer;
+    } else if (mode != "broadcast" && mode != "typed" && mode != "auto" && mode != "spill" && mode != "elastic") {
+        std::cerr << "Invalid mode: " << mode << std::endl;
+        exit(1);
+    }
+    if (check >= CHECK_INTEGRITY && (mode == "broadcast" || mode == "typed" || mode == "spill" || mode == "elastic")) {
+        std::cerr << "Integrity checks are not supported in mode " << mode << std::endl;
+        exit(1);
     }
+    bool verify = check == CHECK_PAYLOAD;
 
     std::vector<std::vector<std::string>> data;
-    std::string filename = "data/" + mode + ".csv";
-    std::vector<std::string> header = {"mode", "num_producers", "throughput_mps"};
+    //* Builds with other orderings, tracing or optimization, and integrity-checked runs, are kept apart, so they can be compared against the plain runs.
+    std::string variant = mode + orderTag();
+#ifdef TRACE
+    variant += "-trace";
+#endif
+#ifdef TELEMETRY
+    variant += "-telemetry";
+#endif
+    if (check == CHECK_INTEGRITY) variant += "-integrity";
+    if (check == CHECK_FAULTS) variant += "-faults";
+#ifdef __OPTIMIZE__
+    variant += "-O2";
+#endif
+    std::string run = variant + ((numBusy)? "-busy" + std::to_string(numBusy) : "");
+    std::string filename = "data/" + run + ".csv";
+    std::vector<std::string> header = {"mode", "num_producers", "throughput_mps", "cpu_s_per_mmsg", "busy_threads", "jain_index"};
+    if (mode == "spill") {
+        header.push_back("peak_spill_bytes");
+        header.push_back("recovery_ms");
+    }
+    if (mode == "elastic") {
+        header.push_back("peak_footprint_bytes");
+        header.push_back("final_footprint_bytes");
+        header.push_back("grows");
+        header.push_back("shrinks");
+    }
     data.push_back(header);
+    //* Per-producer rows for the modes driven by runRing.
+    std::vector<std::vector<std::string>> producerData;
+    std::string producerFilename = "data/" + run + "-producers.csv";
+    producerData.push_back({"mode", "num_producers", "repeat", "producer", "delivered_at_first_finish", "p99_insert_ns"});
+
+    //* The original single-producer insert is only safe with one producer.
+    int maxProducers = (mode == "single")? 1 : TOTAL_CORES;
+    int repeats = (mode == "single")? REPEATS*2 : REPEATS;
 
-    for (int numProducers = 1; numProducers <= TOTAL_CORES; numProducers *= 2) {
+    for (int numProducers = 1; numProducers <= maxProducers; numProducers *= 2) {
         std::cout << "Number of producers:\t" << numProducers << std::endl;
-        std::vector <std::thread> threads;
         std::vector<double> throughputs;
         //* Repeat
-        for (int i = 0; i < REPEATS; i++) {
+        for (int i = 0; i < repeats; i++) {
             std::cout << "\tRepeat:\t" << i+1 << std::endl;
             gThroughput = 0;
-            threads.clear();
             throughputs.clear();
-            //* Allocate the ring buffer.
-            BufferT buffer = new char[sizeof(RingBuffer) + CACHE_LINE];
-            RingBuffer* ringBuffer = AllocateMessageBuffer(buffer);
-            if (mode != "tail" && mode != "optimized") ringBuffer->Tail = -1;
-            if (mode == "optimized") gNumProducers = numProducers;
-            
-            for (int id = 0; id < numProducers; id++) {
-                threads.push_back(std::thread(producer, insertFunc, ringBuffer, id));
+            gDeliveredSnapshot.clear();
+            gStopBusy = false;
+            gBusyCpuNs = 0;
+            std::vector<std::thread> busyThreads;
+            for (uint id = 0; id < numBusy; id++) {
+                busyThreads.push_back(std::thread(busyThread));
+            }
+            double cpuStart = processCpuSeconds();
+            if (mode == "broadcast") {
+                runBroadcast(numProducers, verify);
+            } else if (mode == "typed") {
+                runTyped(numProducers, verify);
+            } else if (mode == "spill") {
+                runSpill(numProducers, verify);
+            } else if (mode == "elastic") {
+                runElastic(numProducers, verify);
+            } else {
+                runRing(insertFunc, mode, numProducers, check);
             }
-            threads.push_back(std::thread(consumer, ringBuffer, numProducers, verify));
 
-            for (auto &thread : threads) {
+            gStopBusy = true;
+            for (auto &thread : busyThreads) {
                 thread.join();
             }
-            
-            //* Deallocate the ring buffer
-            DeallocateMessageBuffer(ringBuffer);
-            delete[] buffer;
+
+            //* Covers the warmup too, unlike the throughput.
+            double cpuPerMillion = (processCpuSeconds() - cpuStart - gBusyCpuNs / 1e9) / ((double)NUM_MESSAGES * numProducers / 1e6);
+            std::cout << "\tCPU:\t" << cpuPerMillion << " s per million messages" << std::endl;
+
+            std::string fairness;
+            if (!gDeliveredSnapshot.empty()) {
+                std::vector<long> p99s;
+                for (int id = 0; id < numProducers; id++) {
+                    p99s.push_back(percentile(gProducerStats[id].Latencies, 0.99));
+                    producerData.push_back({variant, std::to_string(numProducers), std::to_string(i), std::to_string(id),
+                                            std::to_string(gDeliveredSnapshot[id]), std::to_string(p99s.back())});
+                }
+                fairness = std::to_string(jainIndex(gDeliveredSnapshot));
+                std::cout << "\tFairness:\t" << fairness << " Jain, insert p99 " << *std::min_element(p99s.begin(), p99s.end())
+                          << " - " << *std::max_element(p99s.begin(), p99s.end()) << " ns" << std::endl;
+                writeCSV(producerFilename, producerData);
+            }
 
             throughputs.push_back(gThroughput);
-            data.push_back({mode, std::to_string(numProducers), std::to_string(gThroughput)});
+            data.push_back({variant, std::to_string(numProducers), std::to_string(gThroughput), std::to_string(cpuPerMillion), std::to_string(numBusy), fairness});
+            if (mode == "spill") {
+                data.back().push_back(std::to_string(gSpillPeakBytes));
+                data.back().push_back(std::to_string(gSpillRecoveryMs));
+            }
+            if (mode == "elastic") {
+                data.back().push_back(std::to_string(gElasticPeakBytes));
+                data.back().push_back(std::to_string(gElasticFinalBytes));
+                data.back().push_back(std::to_string(gElasticGrows));
+                data.back().push_back(std::to_string(gElasticShrinks));
+            }
             //* Checkpointing to prevent server down time.
             writeCSV(filename, data);
         }
@@ -0,0 +1,164 @@
+#include "common.hpp"
+#include "tail.hpp"
+#include "shm.hpp"
+
+#include <sys/wait.h>
+
+#define LATENCY_SAMPLE 64
+#define HEARTBEAT_INTERVAL 4096
+
+
+struct ShmResult {
+    double Throughput;
+    long P50;
+    long P99;
+};
+
+long nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//* The 8-byte payload carries the send time (steady_clock is system-wide, so it is valid across processes).
+void producer(RingBuffer *ringBuffer, SharedMessageBuffer *shared)
+{
+    for (size_t i = 0; i < NUM_MESSAGES; i++) {
+        long sentAt = nowNs();
+        size_t retries = 0;
+        while (!TailInsertToMessageBuffer(ringBuffer, (BufferT)&sentAt, sizeof(sentAt))) {
+            if (shared && ++retries % HEARTBEAT_INTERVAL == 0) SharedHeartbeat(shared);
+        }
+        if (shared && i % HEARTBEAT_INTERVAL == 0) SharedHeartbeat(shared);
+    }
+}
+
+ShmResult consumer(RingBuffer *ringBuffer, uint numProducers, SharedMessageBuffer *shared)
+{
+    size_t receivedCount = 0;
+    size_t measuredCount = 0;
+    size_t idleRounds = 0;
+    size_t visitedCount = 0;
+    bool warmedUp = false;
+    std::vector<long> latencies;
+    latencies.reserve(NUM_MESSAGES * numProducers / LATENCY_SAMPLE + 1);
+
+    auto visitor = [&](BufferT messagePtr, MessageSizeT messageSize) {
+        if (warmedUp && ++visitedCount % LATENCY_SAMPLE == 0) {
+            latencies.push_back(nowNs() - *(long *)messagePtr);
+        }
+    };
+
+    std::chrono::high_resolution_clock::time_point startTime;
+    while (receivedCount < NUM_MESSAGES * numProducers) {
+        size_t consumed = ConsumeMessages(ringBuffer, visitor, CONSUME_BATCH);
+        if (!consumed) {
+            //* A producer that died mid-insert stalls the ring for good; stop instead of spinning forever.
+            if (shared && ++idleRounds % (1 << 20) == 0 && SharedDeadPeers(shared)) {
+                std::cerr << "Producer process died after " << receivedCount << " messages" << std::endl;
+                break;
+            }
+            continue;
+        }
+        idleRounds = 0;
+        receivedCount += consumed;
+        measuredCount += consumed;
+
+        if (!warmedUp && receivedCount >= WARMUP_MESSAGES) {
+            startTime = std::chrono::high_resolution_clock::now();
+            measuredCount = 0;
+            warmedUp = true;
+        }
+    }
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
+    std::cout << "\tDuration:\t" << duration.count() << " ms" << std::endl;
+
+    ShmResult result = {(double)(measuredCount) / (duration.count() / 1000.0), 0, 0};
+    if (!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        result.P50 = latencies[latencies.size() / 2];
+        result.P99 = latencies[latencies.size() * 99 / 100];
+    }
+    return result;
+}
+
+ShmResult runThreads(uint numProducers)
+{
+    BufferT buffer = new char[sizeof(RingBuffer) + CACHE_LINE];
+    RingBuffer* ringBuffer = AllocateMessageBuffer(buffer);
+    std::vector<std::thread> threads;
+
+    for (uint id = 0; id < numProducers; id++) {
+        threads.push_back(std::thread(producer, ringBuffer, nullptr));
+    }
+    ShmResult result = consumer(ringBuffer, numProducers, nullptr);
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    DeallocateMessageBuffer(ringBuffer);
+    delete[] buffer;
+
+    return result;
+}
+
+//* Each producer is a forked process that attaches to the named ring like an unrelated process would.
+ShmResult runProcesses(uint numProducers)
+{
+    std::string name = "/ringbuffer-" + std::to_string(getpid());
+    SharedMessageBuffer shared;
+    if (!CreateSharedMessageBuffer(name.c_str(), &shared)) {
+        exit(EXIT_FAILURE);
+    }
+
+    std::vector<pid_t> children;
+    for (uint id = 0; id < numProducers; id++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            SharedMessageBuffer attached;
+            if (!AttachSharedMessageBuffer(name.c_str(), &attached)) {
+                _exit(EXIT_FAILURE);
+            }
+            producer(attached.Ring, &attached);
+            DetachSharedMessageBuffer(&attached, name.c_str());
+            _exit(EXIT_SUCCESS);
+        }
+        children.push_back(pid);
+    }
+
+    ShmResult result = consumer(shared.Ring, numProducers, &shared);
+
+    for (pid_t pid : children) {
+        waitpid(pid, nullptr, 0);
+    }
+    DetachSharedMessageBuffer(&shared, name.c_str());
+
+    return result;
+}
+
+int main(int argc, char *argv[]) {
+    std::vector<std::vector<std::string>> data;
+    std::string filename = "data/shm.csv";
+    std::vector<std::string> header = {"transport", "num_producers", "throughput_mps", "p50_latency_ns", "p99_latency_ns"};
+    data.push_back(header);
+
+    for (std::string transport : {"thread", "process"}) {
+        std::cout << "Transport:\t" << transport << std::endl;
+        for (int numProducers = 1; numProducers <= TOTAL_CORES/2; numProducers *= 2) {
+            std::cout << "Number of producers:\t" << numProducers << std::endl;
+            for (int i = 0; i < REPEATS; i++) {
+                std::cout << "\tRepeat:\t" << i+1 << std::endl;
+                ShmResult result = (transport == "thread")? runThreads(numProducers) : runProcesses(numProducers);
+                std::cout << "\tThroughput:\t" << result.Throughput << " MPS, p50 " << result.P50 << " ns, p99 " << result.P99 << " ns" << std::endl;
+                data.push_back({transport, std::to_string(numProducers), std::to_string(result.Throughput),
+                                std::to_string(result.P50), std::to_string(result.P99)});
+                writeCSV(filename, data);
+            }
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,151 @@
+#include "common.hpp"
+#include "tail.hpp"
+#include "sink.hpp"
+
+#include <ctime>
+
+#define SINK_MESSAGE_SIZE 1020
+#define SINK_BYTES 1073741824
+#define SINK_PATH "/dev/shm/ringbuffer-sink.bin"
+
+
+struct SinkResult {
+    double Throughput;
+    double CpuPerGB;
+};
+
+double threadCpuSeconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void producer(RingBuffer *ringBuffer, size_t numMessages)
+{
+    std::vector<char> message(SINK_MESSAGE_SIZE, 'A');
+    for (size_t i = 0; i < numMessages; i++)
+        while(!TailInsertToMessageBuffer(ringBuffer, message.data(), SINK_MESSAGE_SIZE))
+            ;
+}
+
+//* Current path: copy the committed region out of the ring, then write it.
+bool copySink(RingBuffer *ringBuffer, const char *path, unsigned long long totalBytes)
+{
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) {
+        std::cerr << "Error opening " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    std::vector<char> payloadBuf(RING_SIZE);
+    MessageSizeT fetchedBytes;
+    unsigned long long writtenBytes = 0;
+
+    while (writtenBytes < totalBytes) {
+        if (!FetchFromMessageBuffer(ringBuffer, (BufferT)payloadBuf.data(), &fetchedBytes)) {
+            continue;
+        }
+        for (MessageSizeT done = 0; done < fetchedBytes; ) {
+            ssize_t written = write(fd, payloadBuf.data() + done, fetchedBytes - done);
+            if (written <= 0) {
+                std::cerr << "Write failed: " << strerror(errno) << std::endl;
+                close(fd);
+                return false;
+            }
+            done += written;
+        }
+        writtenBytes += fetchedBytes;
+    }
+
+    close(fd);
+    return true;
+}
+
+//* Zero-copy path: hand committed ring regions to the kernel (io_uring, or pwrite as fallback).
+bool ringSink(RingBuffer *ringBuffer, const char *path, unsigned long long totalBytes, bool useUring)
+{
+    RingSink sink;
+    if (!OpenRingSink(&sink, ringBuffer, path, useUring)) {
+        return false;
+    }
+    std::cout << "\tSink:\t" << ((sink.UringFd < 0)? "pwrite" : (sink.Registered? "io_uring (fixed buffer)" : "io_uring")) << std::endl;
+
+    unsigned long long submittedBytes = 0;
+    while (submittedBytes < totalBytes) {
+        long long submitted = SinkMessageBuffer(&sink, ringBuffer);
+        if (submitted < 0) {
+            CloseRingSink(&sink);
+            return false;
+        }
+        submittedBytes += submitted;
+    }
+    bool flushed = FlushRingSink(&sink, ringBuffer);
+
+    CloseRingSink(&sink);
+    return flushed;
+}
+
+SinkResult run(const std::string &mode, uint numProducers, const char *path)
+{
+    BufferT buffer = new char[sizeof(RingBuffer) + CACHE_LINE];
+    RingBuffer* ringBuffer = AllocateMessageBuffer(buffer);
+    std::vector<std::thread> threads;
+
+    MessageSizeT frameBytes = (sizeof(MessageSizeT) + SINK_MESSAGE_SIZE + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+    size_t perProducer = SINK_BYTES / frameBytes / numProducers;
+    unsigned long long totalBytes = (unsigned long long)perProducer * numProducers * frameBytes;
+
+    for (uint id = 0; id < numProducers; id++) {
+        threads.push_back(std::thread(producer, ringBuffer, perProducer));
+    }
+
+    SinkResult result = {0, 0};
+    std::thread consumer([&] {
+        double cpuStart = threadCpuSeconds();
+        auto startTime = std::chrono::high_resolution_clock::now();
+        bool ok = (mode == "copy")? copySink(ringBuffer, path, totalBytes) : ringSink(ringBuffer, path, totalBytes, mode == "uring");
+        auto endTime = std::chrono::high_resolution_clock::now();
+        if (!ok) {
+            exit(EXIT_FAILURE);
+        }
+        double seconds = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count() / 1e6;
+        result.Throughput = totalBytes / seconds / 1e9;
+        result.CpuPerGB = (threadCpuSeconds() - cpuStart) / (totalBytes / 1e9);
+    });
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    consumer.join();
+
+    DeallocateMessageBuffer(ringBuffer);
+    delete[] buffer;
+    unlink(path);
+
+    return result;
+}
+
+int main(int argc, char *argv[]) {
+    const char *path = (argc > 1)? argv[1] : SINK_PATH;
+    std::cout << "Sink file:\t" << path << std::endl;
+
+    std::vector<std::vector<std::string>> data;
+    std::string filename = "data/sink.csv";
+    std::vector<std::string> header = {"mode", "num_producers", "throughput_gbps", "consumer_cpu_s_per_gb"};
+    data.push_back(header);
+
+    for (std::string mode : {"copy", "pwrite", "uring"}) {
+        std::cout << "Mode:\t" << mode << std::endl;
+        for (int numProducers = 1; numProducers <= TOTAL_CORES/4; numProducers *= 2) {
+            std::cout << "Number of producers:\t" << numProducers << std::endl;
+            for (int i = 0; i < REPEATS; i++) {
+                SinkResult result = run(mode, numProducers, path);
+                std::cout << "\tThroughput:\t" << result.Throughput << " GB/s, consumer CPU " << result.CpuPerGB << " s/GB" << std::endl;
+                data.push_back({mode, std::to_string(numProducers), std::to_string(result.Throughput), std::to_string(result.CpuPerGB)});
+                writeCSV(filename, data);
+            }
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,142 @@
+#include "common.hpp"
+#include "optimized.hpp"
+#include "tail.hpp"
+#include "ticket.hpp"
+#include "spsc.hpp"
+
+#define STRESS_MESSAGES 1000000
+//* Payloads of 16 to 120 bytes give 64 and 128 byte frames, so frames also get split by the wrap.
+#define STRESS_MAX_PAYLOAD 120
+
+
+//* Every message names its producer, its sequence number and its length; the rest is a pattern derived from those.
+struct StressHeader {
+    unsigned int Producer;
+    unsigned int Length;
+    unsigned long long Sequence;
+};
+
+MessageSizeT stressLength(uint producer, size_t sequence)
+{
+    return sizeof(StressHeader) + (producer * 7 + sequence * 13) % (STRESS_MAX_PAYLOAD - sizeof(StressHeader) + 1);
+}
+
+char stressByte(uint producer, size_t sequence, size_t offset)
+{
+    return (char)(producer * 31 + sequence * 17 + offset);
+}
+
+void producer(InsertFunctionT insertFunc, RingBuffer *ringBuffer, uint id, size_t numMessages)
+{
+    char message[STRESS_MAX_PAYLOAD];
+    for (size_t i = 0; i < numMessages; i++) {
+        StressHeader header = {id, stressLength(id, i), i};
+        memcpy(message, &header, sizeof(header));
+        for (size_t offset = sizeof(header); offset < header.Length; offset++)
+            message[offset] = stressByte(id, i, offset);
+
+        while(!insertFunc(ringBuffer, (BufferT)message, header.Length))
+            ;
+    }
+}
+
+//* Checks one frame: every producer's messages must arrive complete and in order. Stale or torn frames,
+//* which a too weak ordering lets the consumer see, fail one of the checks.
+void checkMessage(const char *message, MessageSizeT messageSize, std::vector<size_t> &expected)
+{
+    StressHeader header;
+    memcpy(&header, message, sizeof(header));
+
+    const char *problem = nullptr;
+    if (header.Producer >= expected.size()) {
+        problem = "unknown producer";
+    } else if (header.Sequence != expected[header.Producer]) {
+        problem = "out of sequence";
+    } else if (header.Length != stressLength(header.Producer, header.Sequence) || header.Length > messageSize) {
+        problem = "wrong length";
+    } else {
+        for (size_t offset = sizeof(header); offset < header.Length && !problem; offset++) {
+            if (message[offset] != stressByte(header.Producer, header.Sequence, offset))
+                problem = "corrupted payload";
+        }
+    }
+
+    if (problem) {
+        std::cout << "Stress check failed: " << problem << " (producer " << header.Producer << ", sequence "
+                  << header.Sequence << ", length " << header.Length << ")" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    expected[header.Producer]++;
+}
+
+//* Alternates between the in-place and the copying consumer so both read paths are checked.
+void consumer(RingBuffer *ringBuffer, uint numProducers, size_t numMessages)
+{
+    std::vector<size_t> expected(numProducers, 0);
+    char *payloadBuf = new char[RING_SIZE];
+    size_t receivedCount = 0;
+    bool inPlace = true;
+
+    auto visitor = [&](BufferT messagePtr, MessageSizeT messageSize) {
+        checkMessage(messagePtr, messageSize, expected);
+    };
+
+    while (receivedCount < numMessages * numProducers) {
+        if (inPlace) {
+            receivedCount += ConsumeMessages(ringBuffer, visitor, CONSUME_BATCH);
+        } else {
+            MessageSizeT fetchedBytes = 0;
+            if (FetchFromMessageBuffer(ringBuffer, (BufferT)payloadBuf, &fetchedBytes)) {
+                for (MessageSizeT offset = 0; offset < fetchedBytes; offset += *(MessageSizeT *)(payloadBuf + offset)) {
+                    MessageSizeT frameBytes = *(MessageSizeT *)(payloadBuf + offset);
+                    checkMessage(payloadBuf + offset + sizeof(MessageSizeT), frameBytes - sizeof(MessageSizeT), expected);
+                    receivedCount++;
+                }
+            }
+        }
+        inPlace = !inPlace;
+    }
+
+    delete[] payloadBuf;
+}
+
+int main(int argc, char *argv[]) {
+    std::string mode = (argc > 1)? argv[1] : "optimized";
+    uint numProducers = (argc > 2)? atoi(argv[2]) : TOTAL_CORES;
+    size_t numMessages = (argc > 3)? atol(argv[3]) : STRESS_MESSAGES;
+
+    InsertFunctionT insertFunc = nullptr;
+    if (mode == "optimized") {
+        insertFunc = &OptimizedInsertToMessageBuffer;
+    } else if (mode == "tail") {
+        insertFunc = &TailInsertToMessageBuffer;
+    } else if (mode == "ticket") {
+        insertFunc = &TicketInsertToMessageBuffer;
+    } else if (mode != "auto") {
+        std::cerr << "Usage: " << argv[0] << " [optimized|tail|ticket|auto] [<producers>] [<messages per producer>]" << std::endl;
+        exit(1);
+    }
+    std::cout << "Stress:\t" << mode << ", " << numProducers << " producers, " << numMessages << " messages each" << std::endl;
+
+    BufferT buffer = new char[sizeof(RingBuffer) + CACHE_LINE];
+    RingBuffer* ringBuffer = AllocateMessageBuffer(buffer);
+    if (mode == "auto") insertFunc = RegisterProducers(ringBuffer, numProducers);
+
+    auto startTime = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (uint id = 0; id < numProducers; id++) {
+        threads.push_back(std::thread(producer, insertFunc, ringBuffer, id, numMessages));
+    }
+    threads.push_back(std::thread(consumer, ringBuffer, numProducers, numMessages));
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime);
+
+    std::cout << "\tPassed:\t" << numMessages * numProducers << " messages in order and intact, " << duration.count() << " ms" << std::endl;
+
+    DeallocateMessageBuffer(ringBuffer);
+    delete[] buffer;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,145 @@
+#include "trace.hpp"
+
+#include <algorithm>
+#include <string>
+
+//* Converts a dump of the -DTRACE build (data/trace-<mode>-<producers>.bin) to the Chrome trace event format,
+//* which chrome://tracing and ui.perfetto.dev open. Per producer thread an insert shows up as a "copy" slice
+//* (reserved until it started waiting for Tail) and a "wait Tail" slice (until it committed); the consumer
+//* shows "consume" slices. Each commit is matched to the pickup that consumed its frame.
+
+#define PICKUP_SCAN 64
+
+
+struct Pickup {
+    double Time;
+    int Head;
+    int NewHead;
+};
+
+//* Whether Offset lies in the consumed range [Head, NewHead) of the ring.
+bool covers(const Pickup &pickup, int offset)
+{
+    if (pickup.Head <= pickup.NewHead)
+        return pickup.Head <= offset && offset < pickup.NewHead;
+    return offset >= pickup.Head || offset < pickup.NewHead;
+}
+
+//* Time from the commit at Time of the frame at Offset until the consumer picked it up, -1 if not seen.
+double pickupDelay(const std::vector<Pickup> &pickups, double time, int offset)
+{
+    auto it = std::lower_bound(pickups.begin(), pickups.end(), time,
+                               [](const Pickup &pickup, double t) { return pickup.Time < t; });
+    for (int scanned = 0; it != pickups.end() && scanned < PICKUP_SCAN; ++it, ++scanned) {
+        if (covers(*it, offset))
+            return it->Time - time;
+    }
+    return -1;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <trace.bin> <trace.json>" << std::endl;
+        exit(1);
+    }
+
+    FILE *in = fopen(argv[1], "rb");
+    if (!in) {
+        std::cerr << "Error opening trace: " << argv[1] << std::endl;
+        exit(1);
+    }
+    TraceHeaderT header;
+    if (fread(&header, sizeof(header), 1, in) != 1 || memcmp(header.Magic, TRACE_MAGIC, sizeof(header.Magic))) {
+        std::cerr << "Not a trace: " << argv[1] << std::endl;
+        exit(1);
+    }
+
+    std::vector<TraceThreadT> threads(header.Threads);
+    std::vector<std::vector<TraceEventT>> events(header.Threads);
+    for (unsigned int i = 0; i < header.Threads; i++) {
+        if (fread(&threads[i], sizeof(TraceThreadT), 1, in) != 1) {
+            std::cerr << "Truncated trace: " << argv[1] << std::endl;
+            exit(1);
+        }
+        events[i].resize(threads[i].Count);
+        if (fread(events[i].data(), sizeof(TraceEventT), threads[i].Count, in) != threads[i].Count) {
+            std::cerr << "Truncated trace: " << argv[1] << std::endl;
+            exit(1);
+        }
+    }
+    fclose(in);
+
+    auto micros = [&](const TraceEventT &event) { return (double)(long long)(event.Tsc - header.BaseTsc) / header.TicksPerUs; };
+
+    //* Consumer pickups in time order, to match commits against.
+    std::vector<Pickup> pickups;
+    for (auto &thread : events) {
+        for (size_t i = 0; i + 1 < thread.size(); i++) {
+            if (thread[i].Kind == TRACE_PICKUP && thread[i + 1].Kind == TRACE_RELEASE)
+                pickups.push_back({micros(thread[i]), thread[i].Offset, thread[i + 1].Offset});
+        }
+    }
+    std::sort(pickups.begin(), pickups.end(), [](const Pickup &a, const Pickup &b) { return a.Time < b.Time; });
+
+    FILE *out = fopen(argv[2], "w");
+    if (!out) {
+        std::cerr << "Error opening file: " << argv[2] << std::endl;
+        exit(1);
+    }
+    fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    fprintf(out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"ringbuffer\"}}");
+
+    for (unsigned int t = 0; t < header.Threads; t++) {
+        const std::vector<TraceEventT> &thread = events[t];
+        bool isConsumer = std::any_of(thread.begin(), thread.end(), [](const TraceEventT &e) { return e.Kind == TRACE_PICKUP; });
+        fprintf(out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"%s %u\"}}",
+                threads[t].Thread, isConsumer? "consumer" : "producer", threads[t].Thread);
+
+        size_t inserts = 0;
+        double waitSum = 0, waitMax = 0, delaySum = 0;
+        size_t delays = 0;
+        for (size_t i = 0; i < thread.size(); i++) {
+            const TraceEventT &event = thread[i];
+            if (event.Kind == TRACE_RESERVE && i + 2 < thread.size()
+                && thread[i + 1].Kind == TRACE_WAIT && thread[i + 2].Kind == TRACE_COMMIT) {
+                double reserved = micros(event), waiting = micros(thread[i + 1]), committed = micros(thread[i + 2]);
+                double delay = pickupDelay(pickups, committed, event.Offset);
+                fprintf(out, ",\n{\"name\":\"copy\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,"
+                             "\"args\":{\"offset\":%d,\"bytes\":%u}}",
+                        threads[t].Thread, reserved, waiting - reserved, event.Offset, (unsigned int)event.Arg);
+                fprintf(out, ",\n{\"name\":\"wait Tail\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,"
+                             "\"args\":{\"offset\":%d,\"pickup_us\":%.3f}}",
+                        threads[t].Thread, waiting, committed - waiting, event.Offset, delay);
+                inserts++;
+                waitSum += committed - waiting;
+                waitMax = std::max(waitMax, committed - waiting);
+                if (delay >= 0) {
+                    delaySum += delay;
+                    delays++;
+                }
+                i += 2;
+            } else if (event.Kind == TRACE_PICKUP && i + 1 < thread.size() && thread[i + 1].Kind == TRACE_RELEASE) {
+                fprintf(out, ",\n{\"name\":\"consume\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,"
+                             "\"args\":{\"head\":%d,\"new_head\":%d,\"frames\":%u}}",
+                        threads[t].Thread, micros(event), micros(thread[i + 1]) - micros(event),
+                        event.Offset, thread[i + 1].Offset, (unsigned int)thread[i + 1].Arg);
+                i += 1;
+            }
+        }
+
+        std::cout << ((isConsumer)? "Consumer " : "Producer ") << threads[t].Thread << ":\t" << thread.size() << " events, "
+                  << threads[t].Dropped << " older ones overwritten";
+        if (inserts) {
+            std::cout << ", wait on Tail mean " << waitSum / inserts << " us, max " << waitMax << " us";
+        }
+        if (delays) {
+            std::cout << ", commit to pickup mean " << delaySum / delays << " us";
+        }
+        std::cout << std::endl;
+    }
+
+    fprintf(out, "\n]}\n");
+    fclose(out);
+
+    return EXIT_SUCCESS;
+}